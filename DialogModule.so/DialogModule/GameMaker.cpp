@@ -0,0 +1,674 @@
+/*
+ 
+ MIT License
+ 
+ Copyright © 2020 Samuel Venable
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+*/
+
+#include "DialogModule.h"
+#include <condition_variable>
+#include <initializer_list>
+#include <functional>
+#include <cstring>
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+#ifdef _WIN32
+#define EXPORTED_FUNCTION extern "C" __declspec(dllexport)
+#else /* macOS, Linux, and BSD */
+#define EXPORTED_FUNCTION extern "C" __attribute__((visibility("default")))
+#endif
+
+EXPORTED_FUNCTION double show_message(char *str);
+EXPORTED_FUNCTION double show_message_async(char *str);
+EXPORTED_FUNCTION double show_message_cancelable(char *str);
+EXPORTED_FUNCTION double show_message_cancelable_async(char *str);
+EXPORTED_FUNCTION double show_question(char *str);
+EXPORTED_FUNCTION double show_question_async(char *str);
+EXPORTED_FUNCTION double show_question_cancelable(char *str);
+EXPORTED_FUNCTION double show_question_cancelable_async(char *str);
+EXPORTED_FUNCTION double show_attempt(char *str);
+EXPORTED_FUNCTION double show_attempt_async(char *str);
+EXPORTED_FUNCTION double show_error(char *str, double abort);
+EXPORTED_FUNCTION double show_error_async(char *str, double abort);
+EXPORTED_FUNCTION char *get_string(char *str, char *def);
+EXPORTED_FUNCTION double get_string_async(char *str, char *def);
+EXPORTED_FUNCTION char *get_password(char *str, char *def);
+EXPORTED_FUNCTION double get_password_async(char *str, char *def);
+EXPORTED_FUNCTION double get_integer(char *str, double def);
+EXPORTED_FUNCTION double get_integer_async(char *str, double def);
+EXPORTED_FUNCTION double get_passcode(char *str, double def);
+EXPORTED_FUNCTION double get_passcode_async(char *str, double def);
+EXPORTED_FUNCTION char *get_open_filename(char *filter, char *fname);
+EXPORTED_FUNCTION double get_open_filename_async(char *filter, char *fname);
+EXPORTED_FUNCTION char *get_open_filename_ext(char *filter, char *fname, char *dir, char *title);
+EXPORTED_FUNCTION double get_open_filename_ext_async(char *filter, char *fname, char *dir, char *title);
+EXPORTED_FUNCTION char *get_open_filenames(char *filter, char *fname);
+EXPORTED_FUNCTION double get_open_filenames_async(char *filter, char *fname);
+EXPORTED_FUNCTION char *get_open_filenames_ext(char *filter, char *fname, char *dir, char *title);
+EXPORTED_FUNCTION double get_open_filenames_ext_async(char *filter, char *fname, char *dir, char *title);
+EXPORTED_FUNCTION char *get_save_filename(char *filter, char *fname);
+EXPORTED_FUNCTION double get_save_filename_async(char *filter, char *fname);
+EXPORTED_FUNCTION char *get_save_filename_ext(char *filter, char *fname, char *dir, char *title);
+EXPORTED_FUNCTION double get_save_filename_ext_async(char *filter, char *fname, char *dir, char *title);
+EXPORTED_FUNCTION char *get_directory(char *dname);
+EXPORTED_FUNCTION double get_directory_async(char *dname);
+EXPORTED_FUNCTION char *get_directory_alt(char *capt, char *root);
+EXPORTED_FUNCTION double get_directory_alt_async(char *capt, char *root);
+EXPORTED_FUNCTION double get_color(double defcol);
+EXPORTED_FUNCTION double get_color_async(double defcol);
+EXPORTED_FUNCTION double get_color_ext(double defcol, char *title);
+EXPORTED_FUNCTION double get_color_ext_async(double defcol, char *title);
+EXPORTED_FUNCTION double dialog_set_policy(double policy);
+EXPORTED_FUNCTION double dialog_get_policy();
+EXPORTED_FUNCTION double dialog_queue_depth();
+EXPORTED_FUNCTION double dialog_poll();
+EXPORTED_FUNCTION double dialog_poll_count();
+EXPORTED_FUNCTION double dialog_set_keep_results(double keep);
+EXPORTED_FUNCTION double dialog_result_exists(double id);
+EXPORTED_FUNCTION char *dialog_result_get(double id);
+EXPORTED_FUNCTION double dialog_result_free(double id);
+EXPORTED_FUNCTION char *widget_get_caption();
+EXPORTED_FUNCTION double widget_set_caption(char *str);
+EXPORTED_FUNCTION void *widget_get_owner();
+EXPORTED_FUNCTION double widget_set_owner(void *hwnd);
+EXPORTED_FUNCTION char *widget_get_icon();
+EXPORTED_FUNCTION double widget_set_icon(char *icon);
+EXPORTED_FUNCTION char *widget_get_icon_error();
+EXPORTED_FUNCTION char *widget_get_system();
+EXPORTED_FUNCTION double widget_set_system(char *sys);
+EXPORTED_FUNCTION char *widget_get_system_error();
+EXPORTED_FUNCTION char *widget_get_button_name(double type);
+EXPORTED_FUNCTION double widget_set_button_name(double type, char *name);
+EXPORTED_FUNCTION void RegisterCallbacks(char *arg1, char *arg2, char *arg3, char *arg4);
+
+namespace {
+
+unsigned dialog_identifier = 100;
+void(*CreateAsynEventWithDSMap)(int, int);
+int(*CreateDsMap)(int _num, ...);
+bool(*DsMapAddDouble)(int _index, char *_pKey, double value);
+bool(*DsMapAddString)(int _index, char *_pKey, char *pVal);
+
+enum DIALOG_POLICIES {
+  POLICY_QUEUE,    // wait for the dialogs before it, first in first out.
+  POLICY_REJECT,   // fail at once with a rejected event while another dialog is open or waiting.
+  POLICY_COALESCE  // queue, but a duplicate of an open or waiting dialog gets that dialog's result.
+};
+std::atomic<int> dialog_policy(POLICY_QUEUE);
+std::atomic<size_t> dialog_depth(0); // requests waiting behind the open dialog.
+size_t const dialog_queue_max = 64; // further requests are rejected, whatever the policy.
+
+// what a dialog reports in its async event.
+struct dialog_result {
+  double status = -1;
+  bool rejected = false;
+  std::shared_ptr<const std::string> result; // shared by coalesced duplicates.
+  bool has_value = false;
+  double value = 0;
+  bool abort = false; // show_error_async chose abort; dialog_poll() ends the game after delivering.
+};
+
+dialog_result status_result(double status) {
+  dialog_result result;
+  result.status = status;
+  return result;
+}
+
+dialog_result string_result(std::string &&str) {
+  dialog_result result;
+  result.status = 1;
+  result.result = std::make_shared<const std::string>(std::move(str));
+  return result;
+}
+
+dialog_result value_result(double value) {
+  dialog_result result;
+  result.status = 1;
+  result.has_value = true;
+  result.value = value;
+  return result;
+}
+
+// string results of delivered async calls, by id, until dialog_result_free(). they are only kept after
+// dialog_set_keep_results(1), so games that just read the event's "result" leak nothing. game thread only.
+bool keep_results = false;
+std::unordered_map<unsigned, std::shared_ptr<const std::string>> string_results;
+
+void deliver_result(unsigned id, const dialog_result &result) {
+  if (result.result && keep_results)
+    string_results[id] = result.result;
+  int resultMap = CreateDsMap(0);
+  DsMapAddDouble(resultMap, (char *)"id", id);
+  DsMapAddDouble(resultMap, (char *)"status", result.status);
+  if (result.rejected)
+    DsMapAddDouble(resultMap, (char *)"rejected", 1);
+  if (result.result)
+    DsMapAddString(resultMap, (char *)"result", (char *)result.result->c_str());
+  if (result.has_value)
+    DsMapAddDouble(resultMap, (char *)"value", result.value);
+  CreateAsynEventWithDSMap(resultMap, 63);
+}
+
+struct dialog_completion {
+  unsigned id;
+  dialog_result result;
+  dialog_completion *next;
+};
+
+// finished dialogs waiting for dialog_poll(). any thread pushes onto the head with a compare and swap; the
+// game thread takes the whole list with one exchange, so there is no pop to suffer from aba.
+std::atomic<dialog_completion *> completed(nullptr);
+std::atomic<size_t> completed_count(0);
+
+void post_result(unsigned id, dialog_result result) {
+  dialog_completion *completion = new dialog_completion { id, std::move(result), nullptr };
+  // counted before it is visible, so dialog_poll() never subtracts more than was added.
+  completed_count.fetch_add(1, std::memory_order_relaxed);
+  completion->next = completed.load(std::memory_order_relaxed);
+  while (!completed.compare_exchange_weak(completion->next, completion,
+    std::memory_order_release, std::memory_order_relaxed));
+}
+
+// takes everything posted so far, oldest first.
+dialog_completion *take_completions() {
+  dialog_completion *completion = completed.exchange(nullptr, std::memory_order_acquire);
+  dialog_completion *oldest = nullptr;
+  while (completion) {
+    dialog_completion *next = completion->next;
+    completion->next = oldest;
+    oldest = completion;
+    completion = next;
+  }
+  return oldest;
+}
+
+// one *_async call; it owns copies of its arguments until the dialog returns.
+struct dialog_request {
+  const char *name; // the export, which together with the arguments identifies duplicates.
+  std::vector<std::string> args;
+  double number;
+  std::function<dialog_result(const dialog_request &)> run;
+  std::vector<unsigned> ids; // the caller's id, then those of coalesced duplicates.
+  unsigned generation; // dialog_module::cancel_generation() when queued.
+};
+
+bool same_dialog(const dialog_request &a, const dialog_request &b) {
+  return strcmp(a.name, b.name) == 0 && a.args == b.args && a.number == b.number;
+}
+
+// builds each argument string once, straight from the caller's pointers.
+std::vector<std::string> dialog_args(std::initializer_list<const char *> args) {
+  std::vector<std::string> result;
+  result.reserve(args.size());
+  for (const char *arg : args)
+    result.emplace_back(arg);
+  return result;
+}
+
+// runs the *_async dialogs one at a time on a worker started on first use and joined when the library
+// unloads. the single worker is the admission gate: only the front of the queue is ever shown.
+struct dialog_pool {
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::deque<dialog_request> queue;
+  dialog_request *running = nullptr;
+  std::thread worker;
+  bool stopping = false;
+
+  void work() {
+    for (;;) {
+      dialog_request request;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping) return;
+        request = std::move(queue.front());
+        queue.pop_front();
+        dialog_depth = queue.size();
+        running = &request;
+      }
+      dialog_module::set_cancel_generation(request.generation);
+      dialog_result result = request.run(request);
+      std::vector<unsigned> ids;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = nullptr;
+        ids = std::move(request.ids);
+      }
+      for (size_t i = 0; i < ids.size(); i++)
+        post_result(ids[i], (i + 1 == ids.size()) ? std::move(result) : result);
+    }
+  }
+
+  ~dialog_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+      queue.clear();
+    }
+    wake.notify_all();
+    // a dialog still open would keep the worker from ever returning.
+    dialog_module::cancel_dialogs();
+    // exit() called on the worker itself runs this there, and a thread cannot join itself.
+    if (worker.joinable()) {
+      if (worker.get_id() == std::this_thread::get_id())
+        worker.detach();
+      else
+        worker.join();
+    }
+    // results nobody polled for.
+    for (dialog_completion *completion = take_completions(); completion;) {
+      dialog_completion *next = completion->next;
+      delete completion;
+      completion = next;
+    }
+  }
+};
+
+// a function-local static is built after, and so destroyed before, everything it uses in XLib.cpp.
+dialog_pool &get_dialog_pool() {
+  static dialog_pool pool;
+  return pool;
+}
+
+double dialog_submit(const char *name, std::vector<std::string> args, double number,
+  std::function<dialog_result(const dialog_request &)> run) {
+  unsigned id = dialog_identifier++;
+  int policy = dialog_policy;
+  dialog_pool &pool = get_dialog_pool();
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    dialog_request request = { name, std::move(args), number, std::move(run), { id },
+      dialog_module::cancel_generation() };
+    if (policy == POLICY_COALESCE) {
+      dialog_request *duplicate = (pool.running && same_dialog(*pool.running, request)) ? pool.running : nullptr;
+      for (size_t i = 0; duplicate == nullptr && i < pool.queue.size(); i++)
+        if (same_dialog(pool.queue[i], request)) duplicate = &pool.queue[i];
+      if (duplicate) {
+        duplicate->ids.push_back(id);
+        return (double)id;
+      }
+    }
+    bool busy = (pool.running != nullptr || !pool.queue.empty());
+    if (!(policy == POLICY_REJECT && busy) && pool.queue.size() < dialog_queue_max) {
+      if (!pool.worker.joinable())
+        pool.worker = std::thread(&dialog_pool::work, &pool);
+      pool.queue.push_back(std::move(request));
+      dialog_depth = pool.queue.size();
+      pool.wake.notify_one();
+      return (double)id;
+    }
+  }
+  dialog_result rejected;
+  rejected.rejected = true;
+  post_result(id, std::move(rejected));
+  return (double)id;
+}
+
+} // anonymous namespace
+
+double show_message(char *str) {
+  return dialog_module::show_message(str);
+}
+
+double show_message_async(char *str) {
+  return dialog_submit("show_message", dialog_args({ str }), 0, [](const dialog_request &request) {
+    return status_result(show_message((char *)request.args[0].c_str()));
+  });
+}
+
+double show_message_cancelable(char *str) {
+  return dialog_module::show_message_cancelable(str);
+}
+
+double show_message_cancelable_async(char *str) {
+  return dialog_submit("show_message_cancelable", dialog_args({ str }), 0, [](const dialog_request &request) {
+    return status_result(show_message_cancelable((char *)request.args[0].c_str()));
+  });
+}
+
+double show_question(char *str) {
+  return dialog_module::show_question(str);
+}
+
+double show_question_async(char *str) {
+  return dialog_submit("show_question", dialog_args({ str }), 0, [](const dialog_request &request) {
+    return status_result(show_question((char *)request.args[0].c_str()));
+  });
+}
+
+double show_question_cancelable(char *str) {
+  return dialog_module::show_question_cancelable(str);
+}
+
+double show_question_cancelable_async(char *str) {
+  return dialog_submit("show_question_cancelable", dialog_args({ str }), 0, [](const dialog_request &request) {
+    return status_result(show_question_cancelable((char *)request.args[0].c_str()));
+  });
+}
+
+double show_attempt(char *str) {
+  return dialog_module::show_attempt(str);
+}
+
+double show_attempt_async(char *str) {
+  return dialog_submit("show_attempt", dialog_args({ str }), 0, [](const dialog_request &request) {
+    return status_result(show_attempt((char *)request.args[0].c_str()));
+  });
+}
+
+double show_error(char *str, double abort) {
+  return dialog_module::show_error(str, abort);
+}
+
+double show_error_async(char *str, double abort) {
+  return dialog_submit("show_error", dialog_args({ str }), abort, [](const dialog_request &request) {
+    // never exit() on the worker: the game thread does that in dialog_poll(), as show_error would.
+    dialog_result result = status_result(dialog_module::show_error_choice((char *)request.args[0].c_str(), request.number));
+    result.abort = (result.status == 1);
+    return result;
+  });
+}
+
+char *get_string(char *str, char *def) {
+  return dialog_module::get_string(str, def);
+}
+
+double get_string_async(char *str, char *def) {
+  return dialog_submit("get_string", dialog_args({ str, def }), 0, [](const dialog_request &request) {
+    return string_result(dialog_module::get_string_result(
+      (char *)request.args[0].c_str(), (char *)request.args[1].c_str()));
+  });
+}
+
+char *get_password(char *str, char *def) {
+  return dialog_module::get_password(str, def);
+}
+
+double get_password_async(char *str, char *def) {
+  return dialog_submit("get_password", dialog_args({ str, def }), 0, [](const dialog_request &request) {
+    return string_result(dialog_module::get_password_result(
+      (char *)request.args[0].c_str(), (char *)request.args[1].c_str()));
+  });
+}
+
+double get_integer(char *str, double def) {
+  return dialog_module::get_integer(str, def);
+}
+
+double get_integer_async(char *str, double def) {
+  return dialog_submit("get_integer", dialog_args({ str }), def, [](const dialog_request &request) {
+    return value_result(get_integer((char *)request.args[0].c_str(), request.number));
+  });
+}
+
+double get_passcode(char *str, double def) {
+  return dialog_module::get_passcode(str, def);
+}
+
+double get_passcode_async(char *str, double def) {
+  return dialog_submit("get_passcode", dialog_args({ str }), def, [](const dialog_request &request) {
+    return value_result(get_passcode((char *)request.args[0].c_str(), request.number));
+  });
+}
+
+char *get_open_filename(char *filter, char *fname) {
+  return dialog_module::get_open_filename(filter, fname);
+}
+
+double get_open_filename_async(char *filter, char *fname) {
+  return dialog_submit("get_open_filename", dialog_args({ filter, fname }), 0, [](const dialog_request &request) {
+    return string_result(dialog_module::get_open_filename_result(
+      (char *)request.args[0].c_str(), (char *)request.args[1].c_str()));
+  });
+}
+
+char *get_open_filename_ext(char *filter, char *fname, char *dir, char *title) {
+  return dialog_module::get_open_filename_ext(filter, fname, dir, title);
+}
+
+double get_open_filename_ext_async(char *filter, char *fname, char *dir, char *title) {
+  return dialog_submit("get_open_filename_ext", dialog_args({ filter, fname, dir, title }), 0,
+    [](const dialog_request &request) {
+    return string_result(dialog_module::get_open_filename_ext_result(
+      (char *)request.args[0].c_str(), (char *)request.args[1].c_str(),
+      (char *)request.args[2].c_str(), (char *)request.args[3].c_str()));
+  });
+}
+
+char *get_open_filenames(char *filter, char *fname) {
+  return dialog_module::get_open_filenames(filter, fname);
+}
+
+double get_open_filenames_async(char *filter, char *fname) {
+  return dialog_submit("get_open_filenames", dialog_args({ filter, fname }), 0, [](const dialog_request &request) {
+    return string_result(dialog_module::get_open_filenames_result(
+      (char *)request.args[0].c_str(), (char *)request.args[1].c_str()));
+  });
+}
+
+char *get_open_filenames_ext(char *filter, char *fname, char *dir, char *title) {
+  return dialog_module::get_open_filenames_ext(filter, fname, dir, title);
+}
+
+double get_open_filenames_ext_async(char *filter, char *fname, char *dir, char *title) {
+  return dialog_submit("get_open_filenames_ext", dialog_args({ filter, fname, dir, title }), 0,
+    [](const dialog_request &request) {
+    return string_result(dialog_module::get_open_filenames_ext_result(
+      (char *)request.args[0].c_str(), (char *)request.args[1].c_str(),
+      (char *)request.args[2].c_str(), (char *)request.args[3].c_str()));
+  });
+}
+
+char *get_save_filename(char *filter, char *fname) {
+  return dialog_module::get_save_filename(filter, fname);
+}
+
+double get_save_filename_async(char *filter, char *fname) {
+  return dialog_submit("get_save_filename", dialog_args({ filter, fname }), 0, [](const dialog_request &request) {
+    return string_result(dialog_module::get_save_filename_result(
+      (char *)request.args[0].c_str(), (char *)request.args[1].c_str()));
+  });
+}
+
+char *get_save_filename_ext(char *filter, char *fname, char *dir, char *title) {
+  return dialog_module::get_save_filename_ext(filter, fname, dir, title);
+}
+
+double get_save_filename_ext_async(char *filter, char *fname, char *dir, char *title) {
+  return dialog_submit("get_save_filename_ext", dialog_args({ filter, fname, dir, title }), 0,
+    [](const dialog_request &request) {
+    return string_result(dialog_module::get_save_filename_ext_result(
+      (char *)request.args[0].c_str(), (char *)request.args[1].c_str(),
+      (char *)request.args[2].c_str(), (char *)request.args[3].c_str()));
+  });
+}
+
+char *get_directory(char *dname) {
+  return dialog_module::get_directory(dname);
+}
+
+double get_directory_async(char *dname) {
+  return dialog_submit("get_directory", dialog_args({ dname }), 0, [](const dialog_request &request) {
+    return string_result(dialog_module::get_directory_result((char *)request.args[0].c_str()));
+  });
+}
+
+char *get_directory_alt(char *capt, char *root) {
+  return dialog_module::get_directory_alt(capt, root);
+}
+
+double get_directory_alt_async(char *capt, char *root) {
+  return dialog_submit("get_directory_alt", dialog_args({ capt, root }), 0, [](const dialog_request &request) {
+    return string_result(dialog_module::get_directory_alt_result(
+      (char *)request.args[0].c_str(), (char *)request.args[1].c_str()));
+  });
+}
+
+double get_color(double defcol) {
+  return dialog_module::get_color((int)defcol);
+}
+
+double get_color_async(double defcol) {
+  return dialog_submit("get_color", { }, defcol, [](const dialog_request &request) {
+    return value_result(get_color(request.number));
+  });
+}
+
+double get_color_ext(double defcol, char *title) {
+  return dialog_module::get_color_ext((int)defcol, title);
+}
+
+double get_color_ext_async(double defcol, char *title) {
+  return dialog_submit("get_color_ext", dialog_args({ title }), defcol, [](const dialog_request &request) {
+    return value_result(get_color_ext(request.number, (char *)request.args[0].c_str()));
+  });
+}
+
+double dialog_set_policy(double policy) {
+  if (policy < POLICY_QUEUE || policy > POLICY_COALESCE) return -1;
+  dialog_policy = (int)policy;
+  return 0;
+}
+
+double dialog_get_policy() {
+  return dialog_policy;
+}
+
+double dialog_queue_depth() {
+  return (double)dialog_depth;
+}
+
+double dialog_poll() {
+  size_t delivered = 0;
+  bool abort = false;
+  for (dialog_completion *completion = take_completions(); completion; delivered++) {
+    dialog_completion *next = completion->next;
+    abort = abort || completion->result.abort;
+    deliver_result(completion->id, completion->result);
+    delete completion;
+    completion = next;
+  }
+  completed_count.fetch_sub(delivered, std::memory_order_relaxed);
+  if (abort) exit(0);
+  return (double)delivered;
+}
+
+double dialog_poll_count() {
+  return (double)completed_count.load(std::memory_order_relaxed);
+}
+
+// turning it off frees the results still kept.
+double dialog_set_keep_results(double keep) {
+  keep_results = (keep != 0);
+  if (!keep_results) string_results.clear();
+  return 0;
+}
+
+double dialog_result_exists(double id) {
+  return string_results.count((unsigned)id) ? 1 : 0;
+}
+
+// "" for an id with no kept result as well as for an empty one; dialog_result_exists() tells them apart.
+char *dialog_result_get(double id) {
+  auto it = string_results.find((unsigned)id);
+  if (it == string_results.end()) return (char *)"";
+  return (char *)it->second->c_str();
+}
+
+double dialog_result_free(double id) {
+  return string_results.erase((unsigned)id) ? 0 : -1;
+}
+
+char *widget_get_caption() {
+  return dialog_module::widget_get_caption();
+}
+
+double widget_set_caption(char *str) {
+  dialog_module::widget_set_caption(str);
+  return 0;
+}
+
+char *widget_get_icon() {
+  return dialog_module::widget_get_icon();
+}
+
+double widget_set_icon(char *icon) {
+  dialog_module::widget_set_icon(icon);
+  return 0;
+}
+
+char *widget_get_icon_error() {
+  return dialog_module::widget_get_icon_error();
+}
+
+void *widget_get_owner() {
+  return dialog_module::widget_get_owner();
+}
+
+double widget_set_owner(void *hwnd) {
+  dialog_module::widget_set_owner(hwnd);
+  return 0;
+}
+
+char *widget_get_system() {
+  return dialog_module::widget_get_system();
+}
+
+double widget_set_system(char *sys) {
+  dialog_module::widget_set_system(sys);
+  return 0;
+}
+
+char *widget_get_system_error() {
+  return dialog_module::widget_get_system_error();
+}
+
+char *widget_get_button_name(double type) {
+  return dialog_module::widget_get_button_name(type);
+}
+
+double widget_set_button_name(double type, char *name) {
+  dialog_module::widget_set_button_name(type, name);
+  return 0;
+}
+
+void RegisterCallbacks(char *arg1, char *arg2, char *arg3, char *arg4) {
+  void(*CreateAsynEventWithDSMapPtr)(int, int) = (void(*)(int, int))(arg1);
+  int(*CreateDsMapPtr)(int _num, ...) = (int(*)(int _num, ...))(arg2);
+  CreateAsynEventWithDSMap = CreateAsynEventWithDSMapPtr;
+  CreateDsMap = CreateDsMapPtr;
+
+  bool(*DsMapAddDoublePtr)(int _index, char *_pKey, double value) = (bool(*)(int, char *, double))(arg3);
+  bool(*DsMapAddStringPtr)(int _index, char *_pKey, char *pVal) = (bool(*)(int, char *, char *))(arg4);
+
+  DsMapAddDouble = DsMapAddDoublePtr;
+  DsMapAddString = DsMapAddStringPtr;
+}
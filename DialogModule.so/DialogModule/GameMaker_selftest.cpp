@@ -0,0 +1,69 @@
+// self-checks for the GameMaker exports, linked straight against the module sources. run by Selftest.sh,
+// which puts a stand-in zenity first in PATH, so no dialog ever reaches the screen.
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstdio>
+
+extern "C" {
+  double show_error_async(char *str, double abort);
+  double dialog_poll();
+  double widget_set_system(char *sys);
+  void RegisterCallbacks(char *arg1, char *arg2, char *arg3, char *arg4);
+}
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+  if (!ok) failures++;
+  printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+}
+
+void create_async_event(int map, int event) { }
+int create_ds_map(int num, ...) { return 1; }
+bool ds_map_add_double(int index, char *key, double value) { return true; }
+bool ds_map_add_string(int index, char *key, char *value) { return true; }
+
+void register_callbacks() {
+  RegisterCallbacks((char *)create_async_event, (char *)create_ds_map,
+    (char *)ds_map_add_double, (char *)ds_map_add_string);
+  widget_set_system((char *)"Zenity");
+}
+
+pthread_t game_thread;
+
+void exit_only_from_game_thread() {
+  if (!pthread_equal(pthread_self(), game_thread)) _exit(3);
+}
+
+// choosing abort in show_error_async must end the game from dialog_poll(), not from the worker: exiting
+// there used to run the pool's destructor on the worker, which then tried to join itself.
+void check_error_abort() {
+  pid_t pid = fork();
+  if (pid == 0) {
+    game_thread = pthread_self();
+    atexit(exit_only_from_game_thread);
+    register_callbacks();
+    show_error_async((char *)"selftest", 1);
+    for (int i = 0; i < 1000; i++) {
+      dialog_poll();
+      usleep(10000);
+    }
+    _exit(2);
+  }
+  int status = 0;
+  while (waitpid(pid, &status, 0) == -1);
+  check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "show_error_async abort exits from dialog_poll");
+}
+
+} // anonymous namespace
+
+int main() {
+  check_error_abort();
+  return failures ? 1 : 0;
+}
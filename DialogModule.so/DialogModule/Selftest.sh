@@ -0,0 +1,23 @@
+cd "${0%/*}"
+# builds and runs the self-checks in a scratch directory; a stand-in zenity answers every dialog at once.
+# given "bench", times lodepng_crc32 in both lodepng builds instead of checking.
+out="$(mktemp -d)" || exit 1
+trap 'rm -rf "$out"' EXIT
+printf '#!/bin/sh\nexit 0\n' > "$out/zenity" && chmod +x "$out/zenity"
+g++ -std=c++17 "GameMaker_selftest.cpp" "GameMaker.cpp" "XLib.cpp" "lodepng.cpp" -o "$out/GameMaker_selftest" -pthread -lX11 || exit 1
+PATH="$out:$PATH" "$out/GameMaker_selftest" || exit 1
+g++ -std=c++17 "XLib_selftest.cpp" "lodepng.cpp" -o "$out/XLib_selftest" -pthread -lX11 || exit 1
+"$out/XLib_selftest" || exit 1
+gcc -std=c90 -x c "lodepng.cpp" -c -o "$out/lodepng_c90.o" || { echo "FAILED: lodepng.cpp no longer builds as C90"; exit 1; }
+g++ -std=c++17 -O2 "lodepng_selftest.cpp" "lodepng.cpp" -o "$out/lodepng_selftest" -pthread || exit 1
+g++ -std=c++17 -O2 -DLODEPNG_NO_COMPILE_SIMD "lodepng_selftest.cpp" "lodepng.cpp" -o "$out/lodepng_selftest_scalar" -pthread || exit 1
+if [ "$1" = "bench" ]; then
+  echo "with SIMD:" && "$out/lodepng_selftest" bench
+  echo "without SIMD:" && "$out/lodepng_selftest_scalar" bench
+  exit
+fi
+"$out/lodepng_selftest" > "$out/simd.txt"; simd=$?
+"$out/lodepng_selftest_scalar" > "$out/scalar.txt"; scalar=$?
+cat "$out/simd.txt"
+[ $simd -eq 0 ] && [ $scalar -eq 0 ] || { cat "$out/scalar.txt"; exit 1; }
+cmp -s "$out/simd.txt" "$out/scalar.txt" || { echo "FAILED: the SIMD and scalar builds disagree"; diff "$out/simd.txt" "$out/scalar.txt"; exit 1; }
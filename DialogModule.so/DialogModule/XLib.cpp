@@ -0,0 +1,1968 @@
+/*
+
+ MIT License
+
+ Copyright © 2020 Samuel Venable
+ Copyright © 2020 Robert B. Colton
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+*/
+
+#include "DialogModule.h"
+#include "lodepng.h"
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <cstdint>
+
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+
+#ifdef __linux__ // Linux
+#include <sys/syscall.h>
+#else // BSD
+#include <sys/user.h>
+#include <sys/event.h>
+#include <libutil.h>
+#endif
+
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <libgen.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <poll.h>
+#include <time.h>
+#include <cerrno>
+
+extern char **environ;
+
+using std::string;
+
+namespace dialog_module {
+
+namespace {
+
+int const dm_x11     = -1;
+int const dm_zenity  =  0;
+int const dm_kdialog =  1;
+std::atomic<int> dm_dialogengine(-1);
+
+// dialog status when the chosen system is not installed or could not be run.
+int const dm_missing = -2;
+
+void *owner = NULL;
+string caption;
+string current_icon; // guarded by icon_mutex; read it through icon_path().
+
+enum BUTTON_TYPES {
+  BUTTON_ABORT,
+  BUTTON_IGNORE,
+  BUTTON_OK,
+  BUTTON_CANCEL,
+  BUTTON_YES,
+  BUTTON_NO,
+  BUTTON_RETRY
+};
+int const btn_array_len = 7; // number of items in BUTTON_TYPES enum.
+string btn_array[btn_array_len] = { "Abort", "Ignore", "OK", "Cancel", "Yes", "No", "Retry" }; // default button names.
+
+bool message_cancel  = false;
+bool question_cancel = false;
+
+bool dialog_position = false;
+bool dialog_size     = false;
+
+int      dialog_xpos   = 0;
+int      dialog_ypos   = 0;
+unsigned dialog_width  = 0;
+unsigned dialog_height = 0;
+
+enum ATOM_TYPES {
+  ATOM_NET_ACTIVE_WINDOW,
+  ATOM_NET_WM_PID,
+  ATOM_NET_WM_ICON,
+  ATOM_NET_WM_NAME,
+  ATOM_NET_WM_WINDOW_TYPE,
+  ATOM_NET_WM_WINDOW_TYPE_DIALOG,
+  ATOM_UTF8_STRING,
+  ATOM_KWIN_RUNNING
+};
+int const atom_array_len = 8; // number of items in ATOM_TYPES enum.
+const char *atom_names[atom_array_len] = { "_NET_ACTIVE_WINDOW", "_NET_WM_PID", "_NET_WM_ICON", "_NET_WM_NAME",
+  "_NET_WM_WINDOW_TYPE", "_NET_WM_WINDOW_TYPE_DIALOG", "UTF8_STRING", "KWIN_RUNNING" };
+Atom atom_array[atom_array_len] = { None };
+
+// one connection for the whole module; every use must hold display_mutex.
+std::mutex display_mutex;
+Display *shared_display = NULL;
+
+Display *XSharedDisplay() {
+  if (shared_display == NULL) {
+    shared_display = XOpenDisplay(NULL);
+    if (shared_display != NULL)
+      XInternAtoms(shared_display, (char **)atom_names, atom_array_len, True, atom_array);
+  }
+  return shared_display;
+}
+
+struct shared_display_closer {
+  ~shared_display_closer() {
+    if (shared_display != NULL)
+      XCloseDisplay(shared_display);
+  }
+} display_closer;
+
+struct icon_cache_entry {
+  string path;
+  off_t size;
+  time_t mtime;
+  std::vector<unsigned long> payload;
+};
+
+// ready-to-send _NET_WM_ICON cardinals for current_icon; guarded by icon_mutex.
+icon_cache_entry icon_cache;
+std::mutex icon_mutex;
+
+// working memory of icon decodes, kept between icon changes; guarded by icon_mutex.
+struct icon_arena_holder {
+  LodePNGArena arena;
+  icon_arena_holder() { lodepng_arena_init(&arena, 0); }
+  ~icon_arena_holder() { lodepng_arena_cleanup(&arena); }
+} icon_arena;
+
+void XSetIcon(Display *display, Window window, const std::vector<unsigned long> &payload) {
+  XSynchronize(display, True);
+  Atom property = atom_array[ATOM_NET_WM_ICON];
+  XChangeProperty(display, window, property, XA_CARDINAL, 32, PropModeReplace, (unsigned char *)payload.data(), payload.size());
+  XFlush(display);
+}
+
+Window XGetActiveWindow(Display *display) {
+  unsigned long window;
+  unsigned char *prop;
+
+  Atom actual_type, filter_atom;
+  int actual_format, status;
+  unsigned long nitems, bytes_after;
+
+  int screen = XDefaultScreen(display);
+  window = RootWindow(display, screen);
+  if (window == 0) return 0;
+
+  filter_atom = atom_array[ATOM_NET_ACTIVE_WINDOW];
+  status = XGetWindowProperty(display, window, filter_atom, 0, 1000, False, AnyPropertyType, &actual_type, &actual_format, &nitems, &bytes_after, &prop);
+
+  if (status == Success && prop != NULL) {
+    unsigned long long_property = prop[0] + (prop[1] << 8) + (prop[2] << 16) + (prop[3] << 24);
+    XFree(prop);
+
+    return (Window)long_property;
+  }
+  
+  return 0;
+}
+
+pid_t XGetWindowProcessId(Display *display, Window window) {
+  if (window == 0) return 0;
+  unsigned char *prop;
+
+  Atom actual_type, filter_atom;
+  int actual_format, status;
+  unsigned long nitems, bytes_after;
+
+  filter_atom = atom_array[ATOM_NET_WM_PID];
+  status = XGetWindowProperty(display, window, filter_atom, 0, 1000, False, AnyPropertyType, &actual_type, &actual_format, &nitems, &bytes_after, &prop);
+
+  if (status == Success && prop != NULL) {
+    unsigned long long_property = prop[0] + (prop[1] << 8) + (prop[2] << 16) + (prop[3] << 24);
+    XFree(prop);
+
+    return (pid_t)long_property;
+  }
+  
+  return 0;
+}
+
+void XWaitForActiveWindowChange(Display *display, Atom active_window) {
+  XEvent event;
+  for (;;) {
+    XNextEvent(display, &event);
+    if (event.type == MapNotify) return;
+    if (event.type == PropertyNotify && event.xproperty.atom == active_window) return;
+  }
+}
+
+string string_replace_all(string str, string substr, string newstr) {
+  size_t pos = 0;
+  const size_t sublen = substr.length(), newlen = newstr.length();
+
+  while ((pos = str.find(substr, pos)) != string::npos) {
+    str.replace(pos, sublen, newstr);
+    pos += newlen;
+  }
+
+  return str;
+}
+
+bool file_exists(string fname) {
+  struct stat sb;
+  return (stat(fname.c_str(), &sb) == 0 &&
+    S_ISREG(sb.st_mode) != 0);
+}
+
+string filename_absolute(string fname) {
+  char rpath[PATH_MAX];
+  char *result = realpath(fname.c_str(), rpath);
+  if (result != NULL) {
+    if (file_exists(result)) return result;
+  }
+  return "";
+}
+
+// like filename_absolute(), but keeps the path of a file that does not exist.
+string path_absolute(string fname) {
+  char rpath[PATH_MAX];
+  if (realpath(fname.c_str(), rpath) != NULL) return rpath;
+  if (fname == "" || fname[0] == '/') return fname;
+  char cwd[PATH_MAX];
+  if (getcwd(cwd, sizeof(cwd)) == NULL) return fname;
+  return string(cwd) + string("/") + fname;
+}
+
+string filename_name(string fname) {
+  size_t fp = fname.find_last_of("/");
+  return fname.substr(fp + 1);
+}
+
+string filename_ext(string fname) {
+  fname = filename_name(fname);
+  size_t fp = fname.find_last_of(".");
+  if (fp == string::npos)
+    return "";
+  return fname.substr(fp);
+}
+
+#ifdef __linux__ // Linux
+bool ProcGetParentPid(pid_t pid, pid_t *ppid) {
+  static char buffer[1024];
+  char path[32];
+  snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) return false;
+  ssize_t len = read(fd, buffer, sizeof(buffer) - 1);
+  close(fd);
+  if (len <= 0) return false;
+  buffer[len] = '\0';
+
+  // the command name may contain spaces and parentheses, so parse from the last ')'.
+  char *field = strrchr(buffer, ')');
+  if (field == NULL || field[1] == '\0') return false;
+  field += 2;
+  while (*field != ' ' && *field != '\0') field++;
+  *ppid = (pid_t)strtol(field, NULL, 10);
+  return true;
+}
+#endif
+
+void rgba_to_cardinals_scalar(const unsigned char *rgba, unsigned long *out, size_t count) {
+  for (size_t i = 0; i < count; i++, rgba += 4)
+    out[i] = (unsigned long)rgba[2] | ((unsigned long)rgba[1] << 8) | ((unsigned long)rgba[0] << 16) | ((unsigned long)rgba[3] << 24);
+}
+
+#ifdef __SSE2__
+void rgba_to_cardinals_sse2(const unsigned char *rgba, unsigned long *out, size_t count) {
+  const __m128i mask_ag = _mm_set1_epi32(0xFF00FF00);
+  const __m128i mask_rb = _mm_set1_epi32(0x00FF00FF);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i px = _mm_loadu_si128((const __m128i *)(rgba + i * 4));
+    __m128i rb = _mm_and_si128(px, mask_rb);
+    px = _mm_or_si128(_mm_and_si128(px, mask_ag), _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)));
+    #if ULONG_MAX > 0xFFFFFFFFUL
+    _mm_storeu_si128((__m128i *)(out + i), _mm_unpacklo_epi32(px, _mm_setzero_si128()));
+    _mm_storeu_si128((__m128i *)(out + i + 2), _mm_unpackhi_epi32(px, _mm_setzero_si128()));
+    #else
+    _mm_storeu_si128((__m128i *)(out + i), px);
+    #endif
+  }
+  rgba_to_cardinals_scalar(rgba + i * 4, out + i, count - i);
+}
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DIALOG_MODULE_HAVE_AVX2
+__attribute__((target("avx2")))
+void rgba_to_cardinals_avx2(const unsigned char *rgba, unsigned long *out, size_t count) {
+  const __m256i mask_ag = _mm256_set1_epi32(0xFF00FF00);
+  const __m256i mask_rb = _mm256_set1_epi32(0x00FF00FF);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i px = _mm256_loadu_si256((const __m256i *)(rgba + i * 4));
+    __m256i rb = _mm256_and_si256(px, mask_rb);
+    px = _mm256_or_si256(_mm256_and_si256(px, mask_ag), _mm256_or_si256(_mm256_slli_epi32(rb, 16), _mm256_srli_epi32(rb, 16)));
+    #if ULONG_MAX > 0xFFFFFFFFUL
+    _mm256_storeu_si256((__m256i *)(out + i), _mm256_cvtepu32_epi64(_mm256_castsi256_si128(px)));
+    _mm256_storeu_si256((__m256i *)(out + i + 4), _mm256_cvtepu32_epi64(_mm256_extracti128_si256(px, 1)));
+    #else
+    _mm256_storeu_si256((__m256i *)(out + i), px);
+    #endif
+  }
+  rgba_to_cardinals_scalar(rgba + i * 4, out + i, count - i);
+}
+#endif
+
+typedef void (*rgba_to_cardinals_func)(const unsigned char *, unsigned long *, size_t);
+
+rgba_to_cardinals_func select_rgba_to_cardinals() {
+  #ifdef DIALOG_MODULE_HAVE_AVX2
+  if (__builtin_cpu_supports("avx2")) return rgba_to_cardinals_avx2;
+  #endif
+  #ifdef __SSE2__
+  return rgba_to_cardinals_sse2;
+  #else
+  return rgba_to_cardinals_scalar;
+  #endif
+}
+
+// converts lodepng's RGBA8 output straight into _NET_WM_ICON's 0xAARRGGBB longs.
+void rgba_to_cardinals(const unsigned char *rgba, unsigned long *out, size_t count) {
+  static const rgba_to_cardinals_func convert = select_rgba_to_cardinals();
+  convert(rgba, out, count);
+}
+
+int const icon_size_array_len = 6;
+unsigned const icon_size_array[icon_size_array_len] = { 16, 24, 32, 48, 64, 128 }; // generated _NET_WM_ICON sizes.
+unsigned const icon_native_max = 256; // larger sources only ship the generated sizes.
+unsigned const icon_source_max = 4096; // larger sources are rejected before decoding.
+
+char const icon_file_magic[4] = { 'D', 'M', 'I', 'C' };
+uint32_t const icon_file_version = 1;
+
+void madd_pixel(float *acc, const float *px, float weight) {
+  #ifdef __SSE2__
+  _mm_storeu_ps(acc, _mm_add_ps(_mm_loadu_ps(acc), _mm_mul_ps(_mm_loadu_ps(px), _mm_set1_ps(weight))));
+  #else
+  for (unsigned c = 0; c < 4; c++)
+    acc[c] += px[c] * weight;
+  #endif
+}
+
+// one generated _NET_WM_ICON size; columns holds the horizontal pass of every source row.
+struct scaled_icon {
+  unsigned dstwidth, dstheight;
+  size_t offset; // of its width/height header in the payload
+  std::vector<float> columns;
+};
+
+// builds the icon set from lodepng_decode_rows, so the full RGBA image never exists at once.
+struct icon_set_builder {
+  unsigned width, height;
+  std::vector<float> row;
+  std::vector<scaled_icon> scaled;
+  bool native; // the source size is shipped too, written straight into the payload
+  size_t native_offset;
+  std::vector<unsigned long> *payload;
+};
+
+// lays out the payload: the generated sizes smaller than the source, then the source size itself.
+void begin_icon_set(icon_set_builder &builder, unsigned width, unsigned height) {
+  std::vector<unsigned long> &payload = *builder.payload;
+  unsigned longest = std::max(width, height);
+  builder.width = width;
+  builder.height = height;
+  builder.row.assign((size_t)width * 4, 0.0f);
+  builder.scaled.clear();
+  payload.clear();
+  for (unsigned i = 0; i < icon_size_array_len; i++) {
+    unsigned size = icon_size_array[i];
+    if (size >= longest) break;
+    scaled_icon icon;
+    icon.dstwidth = std::max(1u, (unsigned)((double)width * size / longest + 0.5));
+    icon.dstheight = std::max(1u, (unsigned)((double)height * size / longest + 0.5));
+    icon.offset = payload.size();
+    icon.columns.assign((size_t)icon.dstwidth * height * 4, 0.0f);
+    payload.resize(icon.offset + 2 + (size_t)icon.dstwidth * icon.dstheight);
+    payload[icon.offset] = icon.dstwidth;
+    payload[icon.offset + 1] = icon.dstheight;
+    builder.scaled.push_back(std::move(icon));
+  }
+
+  builder.native = (longest <= icon_native_max);
+  builder.native_offset = payload.size();
+  if (builder.native) {
+    payload.resize(builder.native_offset + 2 + (size_t)width * height);
+    payload[builder.native_offset] = width;
+    payload[builder.native_offset + 1] = height;
+  }
+}
+
+// area-average downscale in premultiplied alpha: the horizontal pass of one source row.
+void add_icon_row(icon_set_builder &builder, const unsigned char *src, unsigned y) {
+  unsigned width = builder.width;
+  if (builder.native)
+    rgba_to_cardinals(src, builder.payload->data() + builder.native_offset + 2 + (size_t)y * width, width);
+  if (builder.scaled.empty()) return;
+
+  std::vector<float> &row = builder.row;
+  for (unsigned x = 0; x < width; x++) {
+    float alpha = src[x * 4 + 3] / 255.0f;
+    row[x * 4 + 0] = src[x * 4 + 0] * alpha;
+    row[x * 4 + 1] = src[x * 4 + 1] * alpha;
+    row[x * 4 + 2] = src[x * 4 + 2] * alpha;
+    row[x * 4 + 3] = src[x * 4 + 3];
+  }
+  for (scaled_icon &icon : builder.scaled) {
+    float xscale = (float)width / icon.dstwidth;
+    float *dst = &icon.columns[(size_t)y * icon.dstwidth * 4];
+    for (unsigned ox = 0; ox < icon.dstwidth; ox++) {
+      float start = ox * xscale, end = start + xscale;
+      for (unsigned x = (unsigned)start; x < width && x < end; x++) {
+        float weight = std::min(end, x + 1.0f) - std::max(start, (float)x);
+        if (weight > 0) madd_pixel(dst + ox * 4, &row[x * 4], weight / xscale);
+      }
+    }
+  }
+}
+
+// the vertical pass, once all rows are in.
+void finish_icon_set(icon_set_builder &builder) {
+  unsigned height = builder.height;
+  for (scaled_icon &icon : builder.scaled) {
+    float yscale = (float)height / icon.dstheight;
+    unsigned long *out = builder.payload->data() + icon.offset + 2;
+    std::vector<float> acc((size_t)icon.dstwidth * 4);
+    for (unsigned oy = 0; oy < icon.dstheight; oy++) {
+      std::fill(acc.begin(), acc.end(), 0.0f);
+      float start = oy * yscale, end = start + yscale;
+      for (unsigned y = (unsigned)start; y < height && y < end; y++) {
+        float weight = std::min(end, y + 1.0f) - std::max(start, (float)y);
+        if (weight <= 0) continue;
+        const float *src = &icon.columns[(size_t)y * icon.dstwidth * 4];
+        for (unsigned ox = 0; ox < icon.dstwidth; ox++)
+          madd_pixel(&acc[ox * 4], src + ox * 4, weight / yscale);
+      }
+      for (unsigned ox = 0; ox < icon.dstwidth; ox++) {
+        float alpha = acc[ox * 4 + 3];
+        unsigned long channel[4] = { 0, 0, 0, 0 };
+        if (alpha >= 0.5f) {
+          for (unsigned c = 0; c < 3; c++)
+            channel[c] = (unsigned long)std::min(255.0f, acc[ox * 4 + c] * 255.0f / alpha + 0.5f);
+          channel[3] = (unsigned long)std::min(255.0f, alpha + 0.5f);
+        }
+        *out++ = channel[2] | (channel[1] << 8) | (channel[0] << 16) | (channel[3] << 24);
+      }
+    }
+    icon.columns.clear();
+  }
+}
+
+unsigned icon_row_callback(void *context, const unsigned char *row, unsigned y, unsigned width, unsigned height) {
+  icon_set_builder *builder = (icon_set_builder *)context;
+  if (y == 0) begin_icon_set(*builder, width, height);
+  add_icon_row(*builder, row, y);
+  return 0;
+}
+
+string icon_file_name() {
+  Dl_info info;
+  if (dladdr((void *)&icon_file_name, &info) == 0 || info.dli_fname == NULL)
+    return "";
+  string module = info.dli_fname;
+  size_t fp = module.find_last_of("/");
+  return ((fp == string::npos) ? string(".") : module.substr(0, fp)) + string("/DialogModule.iconcache");
+}
+
+// the most cardinals an icon set can hold: every generated size plus the native one.
+size_t icon_payload_max() {
+  size_t count = 2 + (size_t)icon_native_max * icon_native_max;
+  for (unsigned i = 0; i < icon_size_array_len; i++)
+    count += 2 + (size_t)icon_size_array[i] * icon_size_array[i];
+  return count;
+}
+
+// checks that the cardinals are a run of width, height, pixels... icons that ends exactly at the end.
+bool valid_icon_set(const std::vector<uint32_t> &cardinals) {
+  size_t i = 0, count = cardinals.size();
+  while (i < count) {
+    if (count - i < 2) return false;
+    uint32_t width = cardinals[i], height = cardinals[i + 1];
+    if (width == 0 || height == 0 || width > icon_native_max || height > icon_native_max) return false;
+    if ((size_t)width * height > count - i - 2) return false;
+    i += 2 + (size_t)width * height;
+  }
+  return count > 0;
+}
+
+// the cache file holds the icon set of the last icon used, keyed like icon_cache.
+bool load_icon_file(const icon_cache_entry &entry, std::vector<unsigned long> &payload) {
+  string fname = icon_file_name();
+  FILE *file = (fname != "") ? fopen(fname.c_str(), "rb") : NULL;
+  if (file == NULL) return false;
+
+  char magic[4];
+  uint32_t version = 0, path_len = 0, count = 0;
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  bool success = fread(magic, 1, 4, file) == 4 && memcmp(magic, icon_file_magic, 4) == 0 &&
+    fread(&version, sizeof(version), 1, file) == 1 && version == icon_file_version &&
+    fread(&size, sizeof(size), 1, file) == 1 && size == (uint64_t)entry.size &&
+    fread(&mtime, sizeof(mtime), 1, file) == 1 && mtime == (int64_t)entry.mtime &&
+    fread(&path_len, sizeof(path_len), 1, file) == 1 && path_len == entry.path.length();
+
+  if (success) {
+    string path(path_len, '\0');
+    success = fread(&path[0], 1, path_len, file) == path_len && path == entry.path &&
+      fread(&count, sizeof(count), 1, file) == 1 && count > 2;
+  }
+
+  // the count comes from disk: it must fit both a real icon set and what is left of the file.
+  if (success) {
+    struct stat info;
+    long header = ftell(file);
+    success = count <= icon_payload_max() && header >= 0 && fstat(fileno(file), &info) == 0 &&
+      (uint64_t)info.st_size == (uint64_t)header + (uint64_t)count * sizeof(uint32_t);
+  }
+
+  if (success) {
+    std::vector<uint32_t> cardinals(count);
+    success = fread(cardinals.data(), sizeof(uint32_t), count, file) == count && valid_icon_set(cardinals);
+    if (success) payload.assign(cardinals.begin(), cardinals.end());
+  }
+
+  fclose(file);
+  return success;
+}
+
+void save_icon_file(const icon_cache_entry &entry) {
+  string fname = icon_file_name();
+  if (fname == "") return;
+  string tmpname = fname + string(".") + std::to_string(getpid());
+  FILE *file = fopen(tmpname.c_str(), "wb");
+  if (file == NULL) return;
+
+  uint32_t version = icon_file_version, path_len = entry.path.length(), count = entry.payload.size();
+  uint64_t size = entry.size;
+  int64_t mtime = entry.mtime;
+  std::vector<uint32_t> cardinals(entry.payload.begin(), entry.payload.end());
+  bool success = fwrite(icon_file_magic, 1, 4, file) == 4 &&
+    fwrite(&version, sizeof(version), 1, file) == 1 &&
+    fwrite(&size, sizeof(size), 1, file) == 1 &&
+    fwrite(&mtime, sizeof(mtime), 1, file) == 1 &&
+    fwrite(&path_len, sizeof(path_len), 1, file) == 1 &&
+    fwrite(entry.path.c_str(), 1, path_len, file) == path_len &&
+    fwrite(&count, sizeof(count), 1, file) == 1 &&
+    fwrite(cardinals.data(), sizeof(uint32_t), count, file) == count;
+
+  if (fclose(file) != 0) success = false;
+  if (!success || rename(tmpname.c_str(), fname.c_str()) != 0)
+    unlink(tmpname.c_str());
+}
+
+struct icon_check_entry {
+  string path;
+  off_t size;
+  time_t mtime;
+  unsigned width, height;
+  string reason; // why the icon is rejected; empty if it is usable.
+};
+
+// header check of the last icon looked at; guarded by icon_mutex.
+icon_check_entry icon_check;
+
+// why the icon passed to widget_set_icon() was rejected, or ""; guarded by icon_mutex.
+string icon_error;
+
+// caller must hold icon_mutex; falls back to assets/icon.png when no icon was set.
+string icon_path() {
+  if (current_icon == "") current_icon = filename_absolute("assets/icon.png");
+  return current_icon;
+}
+
+// caller must hold icon_mutex; reads only the signature and IHDR, once per path, size and mtime.
+bool check_icon(string icon) {
+  struct stat sb;
+  bool exists = (icon != "" && stat(icon.c_str(), &sb) == 0);
+  if (exists && icon_check.path == icon && icon_check.size == sb.st_size && icon_check.mtime == sb.st_mtime)
+    return icon_check.reason.empty();
+
+  icon_check.path = icon;
+  icon_check.size = exists ? sb.st_size : -1;
+  icon_check.mtime = exists ? sb.st_mtime : 0;
+  icon_check.width = icon_check.height = 0;
+  icon_check.reason = "";
+  if (icon == "") {
+    icon_check.reason = "no icon set";
+  } else if (filename_ext(icon) != ".png") {
+    icon_check.reason = "not a .png file";
+  } else if (!exists || !S_ISREG(sb.st_mode)) {
+    icon_check.reason = "file not found";
+  } else {
+    // the 8 byte signature and the 25 byte IHDR chunk open every png.
+    unsigned char header[33];
+    FILE *file = fopen(icon.c_str(), "rb");
+    if (file == NULL) { icon_check.reason = "file could not be opened"; return false; }
+    size_t len = fread(header, 1, sizeof(header), file);
+    fclose(file);
+    LodePNGState state;
+    lodepng_state_init(&state);
+    unsigned error = lodepng_inspect(&icon_check.width, &icon_check.height, &state, header, len);
+    lodepng_state_cleanup(&state);
+    if (error)
+      icon_check.reason = lodepng_error_text(error);
+    else if (std::max(icon_check.width, icon_check.height) > icon_source_max)
+      icon_check.reason = "larger than " + std::to_string(icon_source_max) + " pixels on a side";
+  }
+  return icon_check.reason.empty();
+}
+
+// caller must hold icon_mutex; only decodes again when the path, size or mtime changed.
+bool update_icon_cache(string icon) {
+  if (!check_icon(icon))
+    return false;
+
+  if (icon_cache.path == icon && icon_cache.size == icon_check.size && icon_cache.mtime == icon_check.mtime)
+    return !icon_cache.payload.empty();
+
+  icon_cache.path = icon;
+  icon_cache.size = icon_check.size;
+  icon_cache.mtime = icon_check.mtime;
+  icon_cache.payload.clear();
+  if (load_icon_file(icon_cache, icon_cache.payload))
+    return true;
+
+  LodePNGFileMapping file;
+  unsigned pngwidth, pngheight;
+  unsigned error = lodepng_map_file(&file, icon.c_str());
+  if (!error) {
+    LodePNGState state;
+    lodepng_state_init(&state); // decodes to RGBA8 by default
+    state.arena = &icon_arena.arena;
+    icon_set_builder builder;
+    builder.payload = &icon_cache.payload;
+    error = lodepng_decode_rows(&pngwidth, &pngheight, &state, file.data, file.size, icon_row_callback, &builder);
+    if (!error) finish_icon_set(builder);
+    lodepng_state_cleanup(&state);
+    lodepng_arena_reset(&icon_arena.arena);
+  }
+  lodepng_unmap_file(&file);
+  if (error) {
+    // a header that checks out can still hide broken image data.
+    icon_check.reason = lodepng_error_text(error);
+    icon_cache.payload.clear();
+    return false;
+  }
+
+  save_icon_file(icon_cache);
+  return true;
+}
+
+bool WaitForChildPidOfPidToExist(pid_t pid, pid_t ppid) {
+  if (pid == ppid || pid <= 1) return false;
+  #ifdef __linux__ // Linux
+  while (pid != ppid && pid > 1) {
+    if (!ProcGetParentPid(pid, &pid)) break;
+  }
+  return (pid == ppid);
+  #else // BSD
+  while (pid != ppid) {
+    if (pid <= 1) break;
+    struct kinfo_proc *proc_info = kinfo_getproc(pid);
+    if (proc_info == NULL) break;
+    pid = proc_info->ki_ppid;
+    free(proc_info);
+  }
+  return (pid == ppid);
+  #endif
+}
+
+// a forked child keeps every descriptor open in the game, including the write end of another thread's
+// dialog pipe, whose reader would then not see end of file until the child exits.
+void close_inherited_descriptors() {
+  #ifdef __linux__ // Linux
+  #ifdef SYS_close_range
+  if (syscall(SYS_close_range, 3, ~0U, 0) == 0) return;
+  #endif
+  long fd_max = sysconf(_SC_OPEN_MAX);
+  for (long fd = 3; fd < ((fd_max > 0) ? fd_max : 1024); fd++)
+    close((int)fd);
+  #else // BSD
+  closefrom(3);
+  #endif
+}
+
+pid_t modify_dialog(pid_t ppid) {
+  pid_t pid = 0;
+  {
+    // atoms are server-wide, so the child can reuse the ones interned here.
+    std::lock_guard<std::mutex> lock(display_mutex);
+    XSharedDisplay();
+  }
+  // forking with the lock held hands the child a consistent copy of the icon cache.
+  std::lock_guard<std::mutex> icon_lock(icon_mutex);
+  bool has_icon = update_icon_cache(icon_path());
+  if ((pid = fork()) == 0) {
+    close_inherited_descriptors();
+    Display *display = XOpenDisplay(NULL);
+    Window window, parent = owner ? (Window)owner : XGetActiveWindow(display);
+    Atom active_window = atom_array[ATOM_NET_ACTIVE_WINDOW];
+
+    // block on root window events instead of polling the x server.
+    XSelectInput(display, DefaultRootWindow(display), PropertyChangeMask | SubstructureNotifyMask);
+    Window previous = None;
+    for (;;) {
+      window = XGetActiveWindow(display);
+      if (window != previous) {
+        previous = window;
+        if (WaitForChildPidOfPidToExist(XGetWindowProcessId(display, window), ppid)) break;
+      }
+      XWaitForActiveWindowChange(display, active_window);
+    }
+    
+    Atom window_type = atom_array[ATOM_NET_WM_WINDOW_TYPE];
+    Atom dialog_type = atom_array[ATOM_NET_WM_WINDOW_TYPE_DIALOG];
+    XChangeProperty(display, window, window_type, XA_ATOM, 32, PropModeReplace, (unsigned char *)&dialog_type, 1);
+    XSetTransientForHint(display, window, parent);
+
+    Atom atom_name = atom_array[ATOM_NET_WM_NAME];
+    Atom atom_utf_type = atom_array[ATOM_UTF8_STRING];
+    char *cstr_caption = (char *)caption.c_str();
+    XChangeProperty(display, window, atom_name, atom_utf_type, 8, PropModeReplace, (unsigned char *)cstr_caption, strlen(cstr_caption));
+  
+    if (has_icon)
+      XSetIcon(display, window, icon_cache.payload);
+
+    XCloseDisplay(display);
+    _exit(0);
+  }
+  return pid;
+}
+
+// for kernels without pidfd_open, or sandboxes that filter it; reaps the child if it exits in time.
+bool poll_for_child_exit(pid_t pid, int timeout_ms) {
+  struct timespec step = { 0, 10 * 1000000 };
+  for (int waited = 0;; waited += 10) {
+    pid_t reaped = waitpid(pid, NULL, WNOHANG);
+    if (reaped == pid || (reaped == -1 && errno != EINTR)) return true;
+    if (waited >= timeout_ms) return false;
+    nanosleep(&step, NULL);
+  }
+}
+
+bool wait_for_child_exit(pid_t pid, int timeout_ms) {
+  #ifdef __linux__ // Linux
+  #ifdef SYS_pidfd_open
+  int pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+  if (pidfd != -1) {
+    struct pollfd pfd = { pidfd, POLLIN, 0 };
+    int ready = 0;
+    while ((ready = poll(&pfd, 1, timeout_ms)) == -1 && errno == EINTR);
+    close(pidfd);
+    return (ready > 0);
+  }
+  #endif
+  return poll_for_child_exit(pid, timeout_ms);
+  #else // BSD
+  int kq = kqueue();
+  if (kq == -1) return poll_for_child_exit(pid, timeout_ms);
+  struct kevent change, event;
+  EV_SET(&change, pid, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, NULL);
+  struct timespec timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000 };
+  int ready = 0;
+  while ((ready = kevent(kq, &change, 1, &event, 1, &timeout)) == -1 && errno == EINTR);
+  close(kq);
+  return (ready > 0);
+  #endif
+}
+
+void terminate_child(pid_t pid) {
+  if (pid <= 0) return;
+  kill(pid, SIGTERM);
+
+  // returns as soon as the child is gone, escalating once if it ignores SIGTERM.
+  if (!wait_for_child_exit(pid, 1000))
+    kill(pid, SIGKILL);
+
+  int status = 0;
+  while (waitpid(pid, &status, 0) == -1 && errno == EINTR);
+}
+
+// spawned children not reaped yet, so cancel_dialogs() can close them; guarded by children_mutex.
+std::mutex children_mutex;
+std::unordered_set<pid_t> open_children;
+unsigned cancel_count = 0; // bumped by cancel_dialogs(); guarded by children_mutex.
+// cancel_count when this thread's dialog was queued, or -1; a later cancel closes its children as they spawn.
+thread_local long long queued_generation = -1;
+
+string process_evaluate(std::vector<string> arguments, int *status, bool modify) {
+  *status = -1;
+  int fd[2];
+  if (pipe2(fd, O_CLOEXEC) == -1)
+    return "";
+
+  std::vector<char *> argv;
+  for (string &argument : arguments)
+    argv.push_back((char *)argument.c_str());
+  argv.push_back(NULL);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fd[1], STDOUT_FILENO);
+  pid_t child = 0;
+  int error = posix_spawnp(&child, argv[0], &actions, NULL, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(fd[1]);
+
+  if (error != 0) {
+    close(fd[0]);
+    return "";
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(children_mutex);
+    open_children.insert(child);
+    if (queued_generation >= 0 && (unsigned)queued_generation != cancel_count) kill(child, SIGTERM);
+  }
+
+  pid_t ppid = getpid();
+  pid_t pid = modify ? modify_dialog(ppid) : 0;
+
+  string str_buffer;
+  char buffer[BUFSIZ];
+  ssize_t nread = 0;
+  while ((nread = read(fd[0], buffer, sizeof(buffer))) != 0) {
+    if (nread == -1) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    str_buffer.append(buffer, nread);
+  }
+  close(fd[0]);
+
+  int wstatus = 0;
+  while (waitpid(child, &wstatus, 0) == -1 && errno == EINTR);
+  if (WIFEXITED(wstatus)) *status = WEXITSTATUS(wstatus);
+  {
+    std::lock_guard<std::mutex> lock(children_mutex);
+    open_children.erase(child);
+  }
+
+  terminate_child(pid);
+  if (!str_buffer.empty() && str_buffer.back() == '\n')
+    str_buffer.pop_back();
+
+  return str_buffer;
+}
+
+string owner_window_id() {
+  if (owner) return std::to_string((unsigned long)owner);
+  std::lock_guard<std::mutex> lock(display_mutex);
+  Display *display = XSharedDisplay();
+  if (display == NULL) return "0";
+  return std::to_string((unsigned long)XGetActiveWindow(display));
+}
+
+std::vector<string> icon_arguments() {
+  string icon;
+  {
+    std::lock_guard<std::mutex> lock(icon_mutex);
+    icon = icon_path();
+  }
+  if (!file_exists(icon)) return { };
+
+  if (dm_dialogengine == dm_zenity)
+    return { string("--window-icon=") + icon };
+
+  return { "--icon", icon };
+}
+
+string add_escaping(string str, bool is_caption, string new_caption) {
+  string result = str; if (is_caption && str == "") result = new_caption;
+
+  if (dm_dialogengine == dm_zenity)
+    result = string_replace_all(result, "_", "__");
+
+  return result;
+}
+
+string remove_trailing_zeros(double numb) {
+  string strnumb = std::to_string(numb);
+
+  while (!strnumb.empty() && strnumb.find('.') != string::npos && (strnumb.back() == '.' || strnumb.back() == '0'))
+    strnumb.pop_back();
+
+  return strnumb;
+}
+
+std::vector<string> string_split(const string &str, char delimiter) {
+  std::vector<string> vec;
+  std::stringstream sstr(str);
+  string tmp;
+
+  while (std::getline(sstr, tmp, delimiter))
+    vec.push_back(tmp);
+
+  return vec;
+}
+
+std::vector<string> zenity_filter(string input) {
+  std::vector<string> stringVec = string_split(input, '|');
+  std::vector<string> arguments;
+  string string_output = "";
+
+  unsigned index = 0;
+  for (string str : stringVec) {
+    if (index % 2 == 0)
+      string_output = string("--file-filter=") + string_replace_all(str, "*.*", "*") + string("|");
+    else {
+      std::replace(str.begin(), str.end(), ';', ' ');
+      string_output += string_replace_all(str, "*.*", "*");
+      arguments.push_back(add_escaping(string_output, false, ""));
+    }
+
+    index += 1;
+  }
+
+  return arguments;
+}
+
+string kdialog_filter(string input) {
+  std::vector<string> stringVec = string_split(input, '|');
+  string string_output = "";
+
+  unsigned index = 0;
+  for (string str : stringVec) {
+    if (index % 2 == 0) {
+      if (index != 0)
+        string_output += "\n";
+      size_t first = str.find('(');
+      if (first != string::npos) {
+        size_t last = str.find(')', first);
+        if (last != string::npos)
+          str.erase(first, last - first + 1);
+      }
+      string_output += str + string(" (");
+    } else {
+      std::replace(str.begin(), str.end(), ';', ' ');
+      string_output += string_replace_all(str, "*.*", "*") + string(")");
+    }
+
+    index += 1;
+  }
+
+  return string_output;
+}
+
+string kdialog_path(string fname) {
+  char cwd[PATH_MAX];
+  string pwd = getcwd(cwd, sizeof(cwd)) ? string(cwd) + string("/") : "";
+  if (fname.length() && fname[0] != '/') return pwd + fname;
+  return pwd;
+}
+
+struct dialog_backend {
+  bool checked;
+  string path;
+  string version;
+};
+
+// indexed by dm_zenity and dm_kdialog; reset by widget_set_system().
+dialog_backend backend_array[2];
+std::mutex engine_mutex;
+
+// why the last dialog could not be shown, or "" if it was; guarded by engine_mutex.
+string system_error;
+
+string find_executable(string name) {
+  const char *env_path = getenv("PATH");
+  std::vector<string> stringVec = string_split(env_path ? env_path : "/usr/local/bin:/usr/bin:/bin", ':');
+
+  for (string dir : stringVec) {
+    if (dir == "") dir = ".";
+    string candidate = dir + string("/") + name;
+    if (access(candidate.c_str(), X_OK) == 0 && file_exists(candidate))
+      return candidate;
+  }
+
+  return "";
+}
+
+// caller must hold engine_mutex.
+dialog_backend &probe_backend(int engine) {
+  dialog_backend &backend = backend_array[engine];
+  if (!backend.checked) {
+    backend.checked = true;
+    backend.path = find_executable((engine == dm_zenity) ? "zenity" : "kdialog");
+    backend.version = "";
+    if (backend.path != "") {
+      int status = -1;
+      string version = process_evaluate({ backend.path, "--version" }, &status, false);
+      if (status == 0) backend.version = (version != "") ? version : "unknown";
+    }
+  }
+  return backend;
+}
+
+void change_relative_to_kwin() {
+  if (dm_dialogengine != dm_x11) return;
+  std::lock_guard<std::mutex> lock(engine_mutex);
+  if (dm_dialogengine != dm_x11) return;
+
+  bool bKWinRunning = false;
+  {
+    std::lock_guard<std::mutex> display_lock(display_mutex);
+    XSharedDisplay();
+    bKWinRunning = (atom_array[ATOM_KWIN_RUNNING] != None);
+  }
+
+  int preferred = bKWinRunning ? dm_kdialog : dm_zenity;
+  int fallback = bKWinRunning ? dm_zenity : dm_kdialog;
+  if (probe_backend(preferred).version == "" && probe_backend(fallback).version != "")
+    preferred = fallback;
+  dm_dialogengine = preferred;
+}
+
+string dialog_evaluate(std::vector<string> arguments, int *status) {
+  *status = -1;
+  if (arguments.empty()) return "";
+
+  string path;
+  {
+    std::lock_guard<std::mutex> lock(engine_mutex);
+    int engine = dm_dialogengine;
+    if (engine == dm_zenity || engine == dm_kdialog) {
+      dialog_backend &backend = probe_backend(engine);
+      if (backend.version != "") path = backend.path;
+    }
+    system_error = (path == "") ? arguments[0] + string(" is not installed or could not be run") : "";
+  }
+
+  if (path == "") {
+    *status = dm_missing;
+    return "";
+  }
+
+  arguments[0] = path;
+  return process_evaluate(arguments, status, true);
+}
+
+int color_get_red(int col) { return ((col & 0x000000FF)); }
+int color_get_green(int col) { return ((col & 0x0000FF00) >> 8); }
+int color_get_blue(int col) { return ((col & 0x00FF0000) >> 16); }
+
+int make_color_rgb(unsigned char r, unsigned char g, unsigned char b) {
+  return r | (g << 8) | (b << 16);
+}
+
+int show_message_helperfunc(char *str) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = message_cancel ? add_escaping(caption, true, "Question") : add_escaping(caption, true, "Information");
+  string caption_previous = caption;
+  caption = (str_title == "Information") ? "Information" : caption;
+  caption = (str_title == "Question") ? "Question" : caption;
+  string window = owner_window_id();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window };
+
+    if (message_cancel) {
+      arguments.push_back("--question");
+      arguments.push_back(string("--ok-label=") + add_escaping(btn_array[BUTTON_OK], true, ""));
+      arguments.push_back(string("--cancel-label=") + add_escaping(btn_array[BUTTON_CANCEL], true, ""));
+    } else {
+      arguments.push_back("--info");
+      arguments.push_back(string("--ok-label=") + add_escaping(btn_array[BUTTON_OK], true, ""));
+    }
+
+    arguments.push_back(string("--title=") + str_title);
+    arguments.push_back("--no-wrap");
+    arguments.push_back(string("--text=") + add_escaping(str, false, ""));
+    arguments.push_back(message_cancel ? "--icon-name=dialog-question" : "--icon-name=dialog-information");
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window };
+
+    if (message_cancel) {
+      arguments.insert(arguments.end(), { "--yesno", add_escaping(str, false, ""),
+        "--yes-label", add_escaping(btn_array[BUTTON_OK], true, ""),
+        "--no-label", add_escaping(btn_array[BUTTON_CANCEL], true, ""), "--icon", "dialog-question" });
+    } else {
+      arguments.insert(arguments.end(), { "--msgbox", add_escaping(str, false, ""),
+        "--ok-label", add_escaping(btn_array[BUTTON_OK], true, ""), "--icon", "dialog-information" });
+    }
+
+    arguments.insert(arguments.end(), { "--title", str_title });
+  }
+
+  int status = -1;
+  dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+  if (status == dm_missing) return dm_missing;
+  if (!message_cancel) return 1;
+  return (status == 0) ? 1 : -1;
+}
+
+int show_question_helperfunc(char *str) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = add_escaping(caption, true, "Question");
+  string caption_previous = caption;
+  caption = (str_title == "Question") ? "Question" : caption;
+  string window = owner_window_id();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window, "--question",
+      string("--ok-label=") + add_escaping(btn_array[BUTTON_YES], true, ""),
+      string("--cancel-label=") + add_escaping(btn_array[BUTTON_NO], true, "") };
+
+    if (question_cancel)
+      arguments.push_back(string("--extra-button=") + add_escaping(btn_array[BUTTON_CANCEL], true, ""));
+
+    arguments.insert(arguments.end(), { string("--title=") + str_title, "--no-wrap",
+      string("--text=") + add_escaping(str, false, ""), "--icon-name=dialog-question" });
+
+    int status = -1;
+    string str_result = dialog_evaluate(arguments, &status);
+    caption = caption_previous;
+    if (status == dm_missing) return dm_missing;
+    if (status == 0) return 1;
+    if (str_result == btn_array[BUTTON_CANCEL]) return -1;
+    return 0;
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      question_cancel ? "--yesnocancel" : "--yesno", add_escaping(str, false, ""),
+      "--yes-label", add_escaping(btn_array[BUTTON_YES], true, ""),
+      "--no-label", add_escaping(btn_array[BUTTON_NO], true, ""),
+      "--title", str_title, "--icon", "dialog-question" };
+
+    int status = -1;
+    dialog_evaluate(arguments, &status);
+    caption = caption_previous;
+    if (status == dm_missing) return dm_missing;
+    if (status == 0) return 1;
+    if (status == 2) return -1;
+    return 0;
+  }
+
+  caption = caption_previous;
+  return 0;
+}
+
+// what the char * functions return: one buffer per thread, valid until that thread's next such call.
+char *result_buffer(string &&result) {
+  static thread_local string buffer;
+  buffer = std::move(result);
+  return (char *)buffer.c_str();
+}
+
+} // anonymous namespace
+
+int show_message(char *str) {
+  message_cancel = false;
+  return show_message_helperfunc(str);
+}
+
+int show_message_cancelable(char *str) {
+  message_cancel = true;
+  return show_message_helperfunc(str);
+}
+
+int show_question(char *str) {
+  question_cancel = false;
+  return show_question_helperfunc(str);
+}
+
+int show_question_cancelable(char *str) {
+  question_cancel = true;
+  return show_question_helperfunc(str);
+}
+
+int show_attempt(char *str) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = add_escaping(caption, true, "Error");
+  string caption_previous = caption;
+  caption = (str_title == "Error") ? "Error" : caption;
+  string window = owner_window_id();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window, "--question",
+      string("--ok-label=") + add_escaping(btn_array[BUTTON_RETRY], true, ""),
+      string("--cancel-label=") + add_escaping(btn_array[BUTTON_CANCEL], true, ""),
+      string("--title=") + str_title, "--no-wrap", string("--text=") + add_escaping(str, false, ""),
+      "--icon-name=dialog-error", "--window-icon=dialog-error" };
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      "--warningyesno", add_escaping(str, false, ""),
+      "--yes-label", add_escaping(btn_array[BUTTON_RETRY], true, ""),
+      "--no-label", add_escaping(btn_array[BUTTON_CANCEL], true, ""),
+      "--title", str_title, "--icon", "dialog-warning" };
+  }
+
+  int status = -1;
+  dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+  if (status == dm_missing) return dm_missing;
+  return (status == 0) ? 0 : -1;
+}
+
+int show_error_choice(char *str, bool abort) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = add_escaping(caption, true, "Error");
+  string caption_previous = caption;
+  caption = (str_title == "Error") ? "Error" : caption;
+  string window = owner_window_id();
+  int result = 0;
+
+  if (dm_dialogengine == dm_zenity) {
+    if (abort) {
+      arguments = { "zenity", string("--attach=") + window, "--info",
+        string("--ok-label=") + add_escaping(btn_array[BUTTON_ABORT], true, "") };
+    } else {
+      arguments = { "zenity", string("--attach=") + window, "--question",
+        string("--ok-label=") + add_escaping(btn_array[BUTTON_ABORT], true, ""),
+        string("--cancel-label=") + add_escaping(btn_array[BUTTON_IGNORE], true, "") };
+    }
+
+    arguments.insert(arguments.end(), { string("--title=") + str_title, "--no-wrap",
+      string("--text=") + add_escaping(str, false, ""), "--icon-name=dialog-error", "--window-icon=dialog-error" });
+
+    int status = -1;
+    dialog_evaluate(arguments, &status);
+    result = (abort || status == 0) ? 1 : -1;
+    if (!abort && status == dm_missing) result = dm_missing;
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    if (abort) {
+      arguments = { "kdialog", string("--attach=") + window,
+        "--sorry", add_escaping(str, false, ""),
+        "--ok-label", add_escaping(btn_array[BUTTON_ABORT], true, "") };
+    } else {
+      arguments = { "kdialog", string("--attach=") + window,
+        "--warningyesno", add_escaping(str, false, ""),
+        "--yes-label", add_escaping(btn_array[BUTTON_ABORT], true, ""),
+        "--no-label", add_escaping(btn_array[BUTTON_IGNORE], true, "") };
+    }
+
+    arguments.insert(arguments.end(), { "--title", str_title, "--icon", "dialog-warning" });
+
+    int status = -1;
+    dialog_evaluate(arguments, &status);
+    if (abort || status == 0) result = 1;
+    else if (status == 1) result = -1;
+    else if (status == dm_missing) result = dm_missing;
+  }
+
+  caption = caption_previous;
+  return result;
+}
+
+int show_error(char *str, bool abort) {
+  int result = show_error_choice(str, abort);
+  if (result == 1) exit(0);
+  return result;
+}
+
+string get_string_result(char *str, char *def) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = add_escaping(caption, true, "Input Query");
+  string caption_previous = caption;
+  caption = (str_title == "Input Query") ? "Input Query" : caption;
+  string window = owner_window_id();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window,
+      "--entry", string("--title=") + str_title, string("--text=") + add_escaping(str, false, ""),
+      string("--entry-text=") + add_escaping(def, false, "") };
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      "--inputbox", add_escaping(str, false, ""), add_escaping(def, false, ""),
+      "--title", str_title };
+    std::vector<string> icon = icon_arguments();
+    arguments.insert(arguments.end(), icon.begin(), icon.end());
+  }
+
+  int status = -1;
+  string result = dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+  return result;
+}
+
+char *get_string(char *str, char *def) {
+  return result_buffer(get_string_result(str, def));
+}
+
+string get_password_result(char *str, char *def) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = add_escaping(caption, true, "Input Query");
+  string caption_previous = caption;
+  caption = (str_title == "Input Query") ? "Input Query" : caption;
+  string window = owner_window_id();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window,
+      "--entry", string("--title=") + str_title, string("--text=") + add_escaping(str, false, ""),
+      "--hide-text", string("--entry-text=") + add_escaping(def, false, "") };
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      "--password", add_escaping(str, false, ""), add_escaping(def, false, ""),
+      "--title", str_title };
+  }
+
+  int status = -1;
+  string result = dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+  return result;
+}
+
+char *get_password(char *str, char *def) {
+  return result_buffer(get_password_result(str, def));
+}
+
+double get_integer(char *str, double def) {
+  double DIGITS_MIN = -999999999999999;
+  double DIGITS_MAX = 999999999999999;
+
+  if (def < DIGITS_MIN) def = DIGITS_MIN;
+  if (def > DIGITS_MAX) def = DIGITS_MAX;
+
+  string str_def = remove_trailing_zeros(def);
+  string str_result = get_string_result(str, (char *)str_def.c_str());
+  double result = strtod(str_result.c_str(), NULL);
+
+  if (result < DIGITS_MIN) result = DIGITS_MIN;
+  if (result > DIGITS_MAX) result = DIGITS_MAX;
+  return result;
+}
+
+double get_passcode(char *str, double def) {
+  double DIGITS_MIN = -999999999999999;
+  double DIGITS_MAX = 999999999999999;
+
+  if (def < DIGITS_MIN) def = DIGITS_MIN;
+  if (def > DIGITS_MAX) def = DIGITS_MAX;
+
+  string str_def = remove_trailing_zeros(def);
+  string str_result = get_password_result(str, (char *)str_def.c_str());
+  double result = strtod(str_result.c_str(), NULL);
+
+  if (result < DIGITS_MIN) result = DIGITS_MIN;
+  if (result > DIGITS_MAX) result = DIGITS_MAX;
+  return result;
+}
+
+string get_open_filename_result(char *filter, char *fname) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = "Open";
+  string caption_previous = caption;
+  caption = str_title;
+  string str_fname = basename(fname);
+  string window = owner_window_id();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window,
+      "--file-selection", string("--title=") + str_title,
+      string("--filename=") + add_escaping(str_fname, false, "") };
+    std::vector<string> filters = zenity_filter(filter);
+    arguments.insert(arguments.end(), filters.begin(), filters.end());
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      "--getopenfilename", kdialog_path(str_fname), kdialog_filter(filter),
+      "--title", str_title };
+  }
+
+  std::vector<string> icon = icon_arguments();
+  arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+  int status = -1;
+  string result = dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+
+  if (file_exists(result))
+    return result;
+
+  return "";
+}
+
+char *get_open_filename(char *filter, char *fname) {
+  return result_buffer(get_open_filename_result(filter, fname));
+}
+
+string get_open_filename_ext_result(char *filter, char *fname, char *dir, char *title) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = add_escaping(title, true, "Open");
+  string caption_previous = caption;
+  caption = (str_title == "Open") ? "Open" : title;
+  string str_fname = basename(fname);
+  string str_dir = dirname(dir);
+  string window = owner_window_id();
+
+  string str_path = fname;
+  if (str_dir[0] != '\0') str_path = str_dir + string("/") + str_fname;
+  str_fname = (char *)str_path.c_str();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window,
+      "--file-selection", string("--title=") + str_title,
+      string("--filename=") + add_escaping(str_fname, false, "") };
+    std::vector<string> filters = zenity_filter(filter);
+    arguments.insert(arguments.end(), filters.begin(), filters.end());
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      "--getopenfilename", kdialog_path(str_fname), kdialog_filter(filter),
+      "--title", str_title };
+  }
+
+  std::vector<string> icon = icon_arguments();
+  arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+  int status = -1;
+  string result = dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+
+  if (file_exists(result))
+    return result;
+
+  return "";
+}
+
+char *get_open_filename_ext(char *filter, char *fname, char *dir, char *title) {
+  return result_buffer(get_open_filename_ext_result(filter, fname, dir, title));
+}
+
+string get_open_filenames_result(char *filter, char *fname) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = "Open";
+  string caption_previous = caption;
+  caption = str_title;
+  string str_fname = basename(fname);
+  string window = owner_window_id();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window,
+      "--file-selection", "--multiple", "--separator=\n", string("--title=") + str_title,
+      string("--filename=") + add_escaping(str_fname, false, "") };
+    std::vector<string> filters = zenity_filter(filter);
+    arguments.insert(arguments.end(), filters.begin(), filters.end());
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      "--getopenfilename", kdialog_path(str_fname), kdialog_filter(filter),
+      "--multiple", "--separate-output", "--title", str_title };
+  }
+
+  std::vector<string> icon = icon_arguments();
+  arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+  int status = -1;
+  string result = dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+  std::vector<string> stringVec = string_split(result, '\n');
+
+  bool success = true;
+  for (const string &str : stringVec) {
+    if (!file_exists(str))
+      success = false;
+  }
+
+  if (success)
+    return result;
+
+  return "";
+}
+
+char *get_open_filenames(char *filter, char *fname) {
+  return result_buffer(get_open_filenames_result(filter, fname));
+}
+
+string get_open_filenames_ext_result(char *filter, char *fname, char *dir, char *title) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = add_escaping(title, true, "Open");
+  string caption_previous = caption;
+  caption = (str_title == "Open") ? "Open" : title;
+  string str_fname = basename(fname);
+  string str_dir = dirname(dir);
+  string window = owner_window_id();
+
+  string str_path = fname;
+  if (str_dir[0] != '\0') str_path = str_dir + string("/") + str_fname;
+  str_fname = (char *)str_path.c_str();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window,
+      "--file-selection", "--multiple", "--separator=\n", string("--title=") + str_title,
+      string("--filename=") + add_escaping(str_fname, false, "") };
+    std::vector<string> filters = zenity_filter(filter);
+    arguments.insert(arguments.end(), filters.begin(), filters.end());
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      "--getopenfilename", kdialog_path(str_fname), kdialog_filter(filter),
+      "--multiple", "--separate-output", "--title", str_title };
+  }
+
+  std::vector<string> icon = icon_arguments();
+  arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+  int status = -1;
+  string result = dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+  std::vector<string> stringVec = string_split(result, '\n');
+
+  bool success = true;
+  for (const string &str : stringVec) {
+    if (!file_exists(str))
+      success = false;
+  }
+
+  if (success)
+    return result;
+
+  return "";
+}
+
+char *get_open_filenames_ext(char *filter, char *fname, char *dir, char *title) {
+  return result_buffer(get_open_filenames_ext_result(filter, fname, dir, title));
+}
+
+string get_save_filename_result(char *filter, char *fname) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = "Save As";
+  string caption_previous = caption;
+  caption = str_title;
+  string str_fname = basename(fname);
+  string window = owner_window_id();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window,
+      "--file-selection", "--save", "--confirm-overwrite", string("--title=") + str_title,
+      string("--filename=") + add_escaping(str_fname, false, "") };
+    std::vector<string> filters = zenity_filter(filter);
+    arguments.insert(arguments.end(), filters.begin(), filters.end());
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      "--getsavefilename", kdialog_path(str_fname), kdialog_filter(filter),
+      "--title", str_title };
+  }
+
+  std::vector<string> icon = icon_arguments();
+  arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+  int status = -1;
+  string result = dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+  return result;
+}
+
+char *get_save_filename(char *filter, char *fname) {
+  return result_buffer(get_save_filename_result(filter, fname));
+}
+
+string get_save_filename_ext_result(char *filter, char *fname, char *dir, char *title) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = add_escaping(title, true, "Save As");
+  string caption_previous = caption;
+  caption = (str_title == "Save As") ? "Save As" : title;
+  string str_fname = basename(fname);
+  string str_dir = dirname(dir);
+  string window = owner_window_id();
+
+  string str_path = fname;
+  if (str_dir[0] != '\0') str_path = str_dir + string("/") + str_fname;
+  str_fname = (char *)str_path.c_str();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window,
+      "--file-selection", "--save", "--confirm-overwrite", string("--title=") + str_title,
+      string("--filename=") + add_escaping(str_fname, false, "") };
+    std::vector<string> filters = zenity_filter(filter);
+    arguments.insert(arguments.end(), filters.begin(), filters.end());
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      "--getsavefilename", kdialog_path(str_fname), kdialog_filter(filter),
+      "--title", str_title };
+  }
+
+  std::vector<string> icon = icon_arguments();
+  arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+  int status = -1;
+  string result = dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+  return result;
+}
+
+char *get_save_filename_ext(char *filter, char *fname, char *dir, char *title) {
+  return result_buffer(get_save_filename_ext_result(filter, fname, dir, title));
+}
+
+string get_directory_result(char *dname) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = "Select Directory";
+  string caption_previous = caption;
+  caption = str_title;
+  string str_dname = dname;
+  string window = owner_window_id();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window,
+      "--file-selection", "--directory", string("--title=") + str_title,
+      string("--filename=") + add_escaping(str_dname, false, "") };
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      "--getexistingdirectory", kdialog_path(str_dname), "--title", str_title };
+  }
+
+  std::vector<string> icon = icon_arguments();
+  arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+  int status = -1;
+  string result = dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+  if (result != "" && result != "/") result += "/";
+  return result;
+}
+
+char *get_directory(char *dname) {
+  return result_buffer(get_directory_result(dname));
+}
+
+string get_directory_alt_result(char *capt, char *root) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = add_escaping(capt, true, "Select Directory");
+  string caption_previous = caption;
+  caption = (str_title == "Select Directory") ? "Select Directory" : capt;
+  string str_dname = root;
+  string window = owner_window_id();
+
+  if (dm_dialogengine == dm_zenity) {
+    arguments = { "zenity", string("--attach=") + window,
+      "--file-selection", "--directory", string("--title=") + str_title,
+      string("--filename=") + add_escaping(str_dname, false, "") };
+  }
+  else if (dm_dialogengine == dm_kdialog) {
+    arguments = { "kdialog", string("--attach=") + window,
+      "--getexistingdirectory", kdialog_path(str_dname), "--title", str_title };
+  }
+
+  std::vector<string> icon = icon_arguments();
+  arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+  int status = -1;
+  string result = dialog_evaluate(arguments, &status);
+  caption = caption_previous;
+  if (result != "" && result != "/") result += "/";
+  return result;
+}
+
+char *get_directory_alt(char *capt, char *root) {
+  return result_buffer(get_directory_alt_result(capt, root));
+}
+
+int get_color(int defcol) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = "Color";
+  string caption_previous = caption;
+  caption = str_title;
+  string str_defcol;
+  string str_result;
+  string window = owner_window_id();
+  std::vector<string> icon = icon_arguments();
+  int status = -1;
+
+  int red; int green; int blue;
+  red = color_get_red(defcol);
+  green = color_get_green(defcol);
+  blue = color_get_blue(defcol);
+
+  if (dm_dialogengine == dm_zenity) {
+    str_defcol = string("rgb(") + std::to_string(red) + string(",") +
+    std::to_string(green) + string(",") + std::to_string(blue) + string(")");
+    arguments = { "zenity", string("--attach=") + window,
+      "--color-selection", "--show-palette", string("--title=") + str_title,
+      string("--color=") + str_defcol };
+    arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+    str_result = dialog_evaluate(arguments, &status);
+    caption = caption_previous;
+    if (status != 0) return -1;
+    str_result = string_replace_all(str_result, "rgba(", "");
+    str_result = string_replace_all(str_result, "rgb(", "");
+    str_result = string_replace_all(str_result, ")", "");
+    std::vector<string> stringVec = string_split(str_result, ',');
+
+    unsigned int index = 0;
+    for (const string &str : stringVec) {
+      if (index == 0) red = strtod(str.c_str(), NULL);
+      if (index == 1) green = strtod(str.c_str(), NULL);
+      if (index == 2) blue = strtod(str.c_str(), NULL);
+      index += 1;
+    }
+
+  } else if (dm_dialogengine == dm_kdialog) {
+    char hexcol[16];
+    snprintf(hexcol, sizeof(hexcol), "%02x%02x%02x", red, green, blue);
+
+    str_defcol = string("#") + string(hexcol);
+    std::transform(str_defcol.begin(), str_defcol.end(), str_defcol.begin(), ::toupper);
+
+    arguments = { "kdialog", string("--attach=") + window,
+      "--getcolor", "--default", str_defcol, "--title", str_title };
+    arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+    str_result = dialog_evaluate(arguments, &status);
+    caption = caption_previous;
+    if (status != 0) return -1;
+    str_result = str_result.substr(1, str_result.length() - 1);
+
+    unsigned int color;
+    std::stringstream ss2;
+    ss2 << std::hex << str_result;
+    ss2 >> color;
+
+    blue = color_get_red(color);
+    green = color_get_green(color);
+    red = color_get_blue(color);
+  }
+
+  return (int)make_color_rgb(red, green, blue);
+}
+
+int get_color_ext(int defcol, char *title) {
+  change_relative_to_kwin();
+  std::vector<string> arguments;
+  string str_title = add_escaping(title, true, "Color");
+  string caption_previous = caption;
+  caption = (str_title == "Color") ? "Color" : title;
+  string str_defcol;
+  string str_result;
+  string window = owner_window_id();
+  std::vector<string> icon = icon_arguments();
+  int status = -1;
+
+  int red; int green; int blue;
+  red = color_get_red(defcol);
+  green = color_get_green(defcol);
+  blue = color_get_blue(defcol);
+
+  if (dm_dialogengine == dm_zenity) {
+    str_defcol = string("rgb(") + std::to_string(red) + string(",") +
+    std::to_string(green) + string(",") + std::to_string(blue) + string(")");
+    arguments = { "zenity", string("--attach=") + window,
+      "--color-selection", "--show-palette", string("--title=") + str_title,
+      string("--color=") + str_defcol };
+    arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+    str_result = dialog_evaluate(arguments, &status);
+    caption = caption_previous;
+    if (status != 0) return -1;
+    str_result = string_replace_all(str_result, "rgba(", "");
+    str_result = string_replace_all(str_result, "rgb(", "");
+    str_result = string_replace_all(str_result, ")", "");
+    std::vector<string> stringVec = string_split(str_result, ',');
+
+    unsigned int index = 0;
+    for (const string &str : stringVec) {
+      if (index == 0) red = strtod(str.c_str(), NULL);
+      if (index == 1) green = strtod(str.c_str(), NULL);
+      if (index == 2) blue = strtod(str.c_str(), NULL);
+      index += 1;
+    }
+
+  } else if (dm_dialogengine == dm_kdialog) {
+    char hexcol[16];
+    snprintf(hexcol, sizeof(hexcol), "%02x%02x%02x", red, green, blue);
+
+    str_defcol = string("#") + string(hexcol);
+    std::transform(str_defcol.begin(), str_defcol.end(), str_defcol.begin(), ::toupper);
+
+    arguments = { "kdialog", string("--attach=") + window,
+      "--getcolor", "--default", str_defcol, "--title", str_title };
+    arguments.insert(arguments.end(), icon.begin(), icon.end());
+
+    str_result = dialog_evaluate(arguments, &status);
+    caption = caption_previous;
+    if (status != 0) return -1;
+    str_result = str_result.substr(1, str_result.length() - 1);
+
+    unsigned int color;
+    std::stringstream ss2;
+    ss2 << std::hex << str_result;
+    ss2 >> color;
+
+    blue = color_get_red(color);
+    green = color_get_green(color);
+    red = color_get_blue(color);
+  }
+
+  return (int)make_color_rgb(red, green, blue);
+}
+
+char *widget_get_caption() {
+  return (char *)caption.c_str();
+}
+
+void widget_set_caption(char *title) {
+  caption = title ? title : "";
+}
+
+void *widget_get_owner() {
+  return owner;
+}
+
+void widget_set_owner(void *hwnd) {
+  owner = hwnd;
+}
+
+char *widget_get_icon() {
+  string icon;
+  {
+    std::lock_guard<std::mutex> lock(icon_mutex);
+    icon = icon_path();
+  }
+  return result_buffer(std::move(icon));
+}
+
+void widget_set_icon(char *icon) {
+  string path = path_absolute(icon);
+  std::lock_guard<std::mutex> lock(icon_mutex);
+  current_icon = path;
+  update_icon_cache(icon_path());
+  icon_error = icon_check.reason;
+}
+
+char *widget_get_icon_error() {
+  string error;
+  {
+    std::lock_guard<std::mutex> lock(icon_mutex);
+    error = icon_error;
+  }
+  return result_buffer(std::move(error));
+}
+
+char *widget_get_system() {
+  if (dm_dialogengine == dm_zenity)
+    return (char *)"Zenity";
+
+  if (dm_dialogengine == dm_kdialog)
+    return (char *)"KDialog";
+
+  return (char *)"X11";
+}
+
+void widget_set_system(char *sys) {
+  string str_sys = sys;
+  std::lock_guard<std::mutex> lock(engine_mutex);
+  backend_array[dm_zenity].checked = false;
+  backend_array[dm_kdialog].checked = false;
+  system_error = "";
+
+  if (str_sys == "X11") {
+    dm_dialogengine = dm_x11;
+    // kwin may have started or stopped since the atoms were interned.
+    std::lock_guard<std::mutex> display_lock(display_mutex);
+    Display *display = XSharedDisplay();
+    if (display != NULL)
+      atom_array[ATOM_KWIN_RUNNING] = XInternAtom(display, atom_names[ATOM_KWIN_RUNNING], True);
+  }
+
+  if (str_sys == "Zenity")
+    dm_dialogengine = dm_zenity;
+
+  if (str_sys == "KDialog")
+    dm_dialogengine = dm_kdialog;
+}
+
+char *widget_get_system_error() {
+  string error;
+  {
+    std::lock_guard<std::mutex> lock(engine_mutex);
+    error = system_error;
+  }
+  return result_buffer(std::move(error));
+}
+
+void widget_set_button_name(double type, char *name) {
+  string str_name = name;
+  
+  btn_array[(int)type] = str_name;
+}
+
+char *widget_get_button_name(double type) {
+  return (char *)btn_array[(int)type].c_str();
+}
+
+unsigned cancel_generation() {
+  std::lock_guard<std::mutex> lock(children_mutex);
+  return cancel_count;
+}
+
+void set_cancel_generation(unsigned generation) {
+  queued_generation = generation;
+}
+
+void cancel_dialogs() {
+  std::lock_guard<std::mutex> lock(children_mutex);
+  cancel_count++;
+  for (pid_t child : open_children)
+    kill(child, SIGTERM);
+}
+
+} // namepace dialog_module
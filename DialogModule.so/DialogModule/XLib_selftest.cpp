@@ -0,0 +1,122 @@
+// self-checks for XLib.cpp internals, which it includes to reach them. run by Selftest.sh.
+
+#include "XLib.cpp"
+#include <cstdio>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+  if (!ok) failures++;
+  printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+}
+
+unsigned random_state = 1;
+
+unsigned random_next() {
+  random_state = random_state * 1103515245u + 12345u;
+  return random_state >> 8;
+}
+
+// what XSetIcon stored per pixel before the one-pass conversion. the int it built sign-extends when alpha
+// is 128 or more, but Xlib only sends the low 32 bits of each long for format 32 properties.
+unsigned long previous_cardinal(const unsigned char *rgba) {
+  return (unsigned long)(rgba[2] | (rgba[1] << 8) | (rgba[0] << 16) | (rgba[3] << 24)) & 0xFFFFFFFFUL;
+}
+
+bool cardinals_match(dialog_module::rgba_to_cardinals_func convert) {
+  std::vector<unsigned char> rgba(4 * 300 + 4);
+  for (unsigned char &byte : rgba) byte = (unsigned char)random_next();
+  // every count up to a few vector widths past the tail, from aligned and unaligned rows.
+  for (size_t offset = 0; offset < 4; offset++) {
+    for (size_t count = 0; count < 300; count++) {
+      std::vector<unsigned long> out(count + 1, 0x5A5A5A5AUL);
+      convert(&rgba[offset], out.data(), count);
+      for (size_t i = 0; i < count; i++)
+        if (out[i] != previous_cardinal(&rgba[offset + i * 4])) return false;
+      if (out[count] != 0x5A5A5A5AUL) return false;
+    }
+  }
+  return true;
+}
+
+void check_cardinals() {
+  check(cardinals_match(dialog_module::rgba_to_cardinals_scalar), "rgba_to_cardinals_scalar");
+  #ifdef __SSE2__
+  check(cardinals_match(dialog_module::rgba_to_cardinals_sse2), "rgba_to_cardinals_sse2");
+  #endif
+  #ifdef DIALOG_MODULE_HAVE_AVX2
+  if (__builtin_cpu_supports("avx2"))
+    check(cardinals_match(dialog_module::rgba_to_cardinals_avx2), "rgba_to_cardinals_avx2");
+  #endif
+  check(cardinals_match(dialog_module::rgba_to_cardinals), "rgba_to_cardinals");
+}
+
+// the decorator asks whether the active window's process descends from the game.
+void check_ancestry() {
+  pid_t child = fork();
+  if (child == 0) {
+    pause();
+    _exit(0);
+  }
+  check(dialog_module::WaitForChildPidOfPidToExist(child, getpid()), "a child descends from its parent");
+  check(!dialog_module::WaitForChildPidOfPidToExist(getpid(), child), "a parent does not descend from its child");
+  kill(child, SIGKILL);
+  waitpid(child, NULL, 0);
+}
+
+// the fallback terminate_child() waits with when pidfd_open is unavailable.
+void check_poll_for_child_exit() {
+  pid_t child = fork();
+  if (child == 0) _exit(0);
+  check(dialog_module::poll_for_child_exit(child, 1000), "polling sees a child exit");
+  check(waitpid(child, NULL, WNOHANG) == -1 && errno == ECHILD, "polling reaps the child");
+
+  child = fork();
+  if (child == 0) {
+    pause();
+    _exit(0);
+  }
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  bool exited = dialog_module::poll_for_child_exit(child, 100);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  long waited_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+  check(!exited && waited_ms >= 100 && waited_ms < 1000, "polling gives up after the timeout");
+  kill(child, SIGKILL);
+  waitpid(child, NULL, 0);
+}
+
+// a dialog's reader must see end of file once its own child exits, even while a decorator forked by another
+// thread lives on.
+void check_close_inherited_descriptors() {
+  int fd[2];
+  if (pipe(fd) == -1) {
+    check(false, "pipe");
+    return;
+  }
+  pid_t child = fork();
+  if (child == 0) {
+    dialog_module::close_inherited_descriptors();
+    pause();
+    _exit(0);
+  }
+  close(fd[1]);
+  struct pollfd pfd = { fd[0], POLLIN, 0 };
+  char byte;
+  check(poll(&pfd, 1, 1000) == 1 && read(fd[0], &byte, 1) == 0, "a forked child drops inherited descriptors");
+  close(fd[0]);
+  kill(child, SIGKILL);
+  waitpid(child, NULL, 0);
+}
+
+} // anonymous namespace
+
+int main() {
+  check_cardinals();
+  check_ancestry();
+  check_poll_for_child_exit();
+  check_close_inherited_descriptors();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,313 @@
+// self-checks for the lodepng fast paths. Selftest.sh runs it twice, once as built and once built with
+// LODEPNG_NO_COMPILE_SIMD; each run checks itself, and both must print the same digests. given "bench", it
+// times lodepng_crc32 instead.
+
+#include "lodepng.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <chrono>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+  if (!ok) {
+    failures++;
+    printf("FAILED: %s\n", what);
+  }
+}
+
+// a fixed seed, so both builds see the same inputs.
+unsigned random_state = 1;
+
+unsigned random_next() {
+  random_state = random_state * 1103515245u + 12345u;
+  return random_state >> 8;
+}
+
+// fnv-1a over everything a section produced.
+struct digest {
+  unsigned long long hash = 14695981039346656037ull;
+  void add(const unsigned char *data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      hash ^= data[i];
+      hash *= 1099511628211ull;
+    }
+  }
+  void print(const char *section) {
+    printf("digest %s %016llx\n", section, hash);
+  }
+};
+
+struct color_type {
+  LodePNGColorType colortype;
+  unsigned bitdepth;
+};
+
+const color_type color_types[] = {
+  { LCT_GREY, 1 }, { LCT_GREY, 2 }, { LCT_GREY, 4 }, { LCT_GREY, 8 }, { LCT_GREY, 16 },
+  { LCT_RGB, 8 }, { LCT_RGB, 16 },
+  { LCT_PALETTE, 1 }, { LCT_PALETTE, 2 }, { LCT_PALETTE, 4 }, { LCT_PALETTE, 8 },
+  { LCT_GREY_ALPHA, 8 }, { LCT_GREY_ALPHA, 16 },
+  { LCT_RGBA, 8 }, { LCT_RGBA, 16 }
+};
+
+// odd widths leave tails behind the vector loops.
+const unsigned widths[] = { 1, 2, 3, 5, 8, 15, 16, 17, 33, 64, 67 };
+
+void random_palette(LodePNGColorMode *mode, unsigned size) {
+  lodepng_palette_clear(mode);
+  for (unsigned i = 0; i < size; i++) {
+    unsigned rgba = random_next();
+    lodepng_palette_add(mode, rgba & 255, (rgba >> 8) & 255, (rgba >> 16) & 255, random_next() & 255);
+  }
+}
+
+// palette indices stay below the palette size, and bits past the last pixel stay zero as the decoder leaves them.
+std::vector<unsigned char> random_pixels(unsigned w, unsigned h, const LodePNGColorMode *mode) {
+  size_t bits = (size_t)w * h * lodepng_get_bpp(mode);
+  std::vector<unsigned char> pixels((bits + 7) / 8);
+  for (unsigned char &byte : pixels) {
+    byte = (unsigned char)random_next();
+    if (mode->colortype == LCT_PALETTE && mode->bitdepth == 8) byte %= mode->palettesize;
+  }
+  if (bits % 8) pixels.back() &= (unsigned char)(0xFF << (8 - bits % 8));
+  return pixels;
+}
+
+// encodes with every filter strategy and decodes the result, so each unfilter kernel has to restore the pixels.
+void check_unfilter() {
+  const LodePNGFilterStrategy strategies[] = {
+    LFS_ZERO, LFS_ONE, LFS_TWO, LFS_THREE, LFS_FOUR, LFS_MINSUM, LFS_ENTROPY, LFS_BRUTE_FORCE, LFS_PREDEFINED
+  };
+  const unsigned height = 5;
+  const unsigned char predefined[height] = { 0, 1, 2, 3, 4 };
+  digest sum;
+  for (const color_type &type : color_types) {
+    for (LodePNGFilterStrategy strategy : strategies) {
+      for (unsigned width : widths) {
+        LodePNGState state;
+        lodepng_state_init(&state);
+        state.info_raw.colortype = type.colortype;
+        state.info_raw.bitdepth = type.bitdepth;
+        if (type.colortype == LCT_PALETTE)
+          random_palette(&state.info_raw, (type.bitdepth == 8) ? 1 + random_next() % 256 : 1u << type.bitdepth);
+        lodepng_color_mode_copy(&state.info_png.color, &state.info_raw);
+        state.encoder.auto_convert = 0;
+        state.encoder.filter_palette_zero = 0;
+        state.encoder.filter_strategy = strategy;
+        state.encoder.predefined_filters = predefined;
+        std::vector<unsigned char> pixels = random_pixels(width, height, &state.info_raw);
+
+        unsigned char *png = NULL, *decoded = NULL;
+        size_t pngsize = 0;
+        unsigned w = 0, h = 0;
+        unsigned error = lodepng_encode(&png, &pngsize, pixels.data(), width, height, &state);
+        check(error == 0, "unfilter: encode");
+        LodePNGState decoder;
+        lodepng_state_init(&decoder);
+        decoder.decoder.color_convert = 0;
+        if (!error) error = lodepng_decode(&decoded, &w, &h, &decoder, png, pngsize);
+        check(error == 0 && w == width && h == height, "unfilter: decode");
+        if (!error) {
+          char what[96];
+          snprintf(what, sizeof(what), "unfilter: colortype %d bitdepth %u strategy %d width %u",
+            (int)type.colortype, type.bitdepth, (int)strategy, width);
+          check(memcmp(decoded, pixels.data(), pixels.size()) == 0, what);
+          sum.add(png, pngsize);
+        }
+        free(png);
+        free(decoded);
+        lodepng_state_cleanup(&decoder);
+        lodepng_state_cleanup(&state);
+      }
+    }
+  }
+  sum.print("unfilter");
+}
+
+// the bytewise definition, which the vector kernels must match at every length and alignment.
+unsigned adler32_reference(const unsigned char *data, size_t size) {
+  unsigned a = 1, b = 0;
+  for (size_t i = 0; i < size; i++) {
+    a = (a + data[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b << 16) | a;
+}
+
+// lengths around the block size the sums are reduced at, then random ones; runs of 255 push the sums
+// closest to overflowing. a zlib stream ends with the adler-32 of its input, and inflate checks it again.
+void check_adler32() {
+  const size_t lengths[] = { 0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 5551, 5552, 5553, 11104, 65536 };
+  std::vector<unsigned char> buffer(70000 + 64);
+  LodePNGCompressSettings compress;
+  lodepng_compress_settings_init(&compress);
+  LodePNGDecompressSettings decompress;
+  lodepng_decompress_settings_init(&decompress);
+  digest sum;
+  for (unsigned round = 0; round < 96; round++) {
+    size_t size = (round < sizeof(lengths) / sizeof(lengths[0])) ? lengths[round] : random_next() % 70000;
+    unsigned char *data = buffer.data() + random_next() % 32;
+    for (size_t i = 0; i < size; i++)
+      data[i] = (round % 3 == 0) ? 255 : (unsigned char)random_next();
+
+    unsigned char *zlib = NULL, *inflated = NULL;
+    size_t zlibsize = 0, inflatedsize = 0;
+    unsigned error = lodepng_zlib_compress(&zlib, &zlibsize, data, size, &compress);
+    check(error == 0 && zlibsize >= 4, "adler32: compress");
+    if (!error && zlibsize >= 4) {
+      const unsigned char *end = zlib + zlibsize - 4;
+      unsigned stored = ((unsigned)end[0] << 24) | ((unsigned)end[1] << 16) | ((unsigned)end[2] << 8) | end[3];
+      char what[64];
+      snprintf(what, sizeof(what), "adler32: length %zu", size);
+      check(stored == adler32_reference(data, size), what);
+      sum.add(end, 4);
+      error = lodepng_zlib_decompress(&inflated, &inflatedsize, zlib, zlibsize, &decompress);
+      check(error == 0 && inflatedsize == size && memcmp(inflated, data, size) == 0, "adler32: inflate");
+    }
+    free(zlib);
+    free(inflated);
+  }
+  sum.print("adler32");
+}
+
+// a sample of a packed, most significant bit first buffer.
+unsigned sample_at(const unsigned char *data, size_t bit, unsigned bits) {
+  unsigned value = 0;
+  for (unsigned i = 0; i < bits; i++, bit++)
+    value = (value << 1) | ((data[bit / 8] >> (7 - bit % 8)) & 1);
+  return value;
+}
+
+// converts to 8 bits per channel, which the vector kernels take, and checks the result against the high bytes
+// of a 16-bit conversion, which only the scalar code does. palette indices may point past the palette, and
+// keyed rows repeat the key.
+void check_convert() {
+  const unsigned palette_sizes[] = { 1, 2, 3, 4, 15, 16, 17, 100, 255, 256 };
+  const LodePNGColorType outputs[] = { LCT_RGBA, LCT_RGB };
+  digest sum;
+  for (const color_type &type : color_types) {
+    bool palette = (type.colortype == LCT_PALETTE);
+    bool keyable = (type.colortype == LCT_GREY || type.colortype == LCT_RGB);
+    for (unsigned palette_size : palette_sizes) {
+      if (palette ? palette_size > (1u << type.bitdepth) : palette_size != 1) continue;
+      for (int keyed = 0; keyed < (keyable ? 2 : 1); keyed++) {
+        LodePNGColorMode in = lodepng_color_mode_make(type.colortype, type.bitdepth);
+        if (palette) random_palette(&in, palette_size);
+        unsigned bpp = lodepng_get_bpp(&in);
+        unsigned width = 1 + random_next() % 600; // past the 256-pixel chunks of the unpacking kernels.
+        std::vector<unsigned char> pixels(((size_t)width * bpp + 7) / 8);
+        for (unsigned char &byte : pixels) byte = (unsigned char)random_next();
+        if (keyed) {
+          for (unsigned i = 3; bpp >= 8 && i < width; i += 3)
+            memcpy(&pixels[i * bpp / 8], &pixels[0], bpp / 8);
+          in.key_defined = 1;
+          in.key_r = sample_at(pixels.data(), 0, type.bitdepth);
+          in.key_g = (type.colortype == LCT_RGB) ? sample_at(pixels.data(), type.bitdepth, type.bitdepth) : in.key_r;
+          in.key_b = (type.colortype == LCT_RGB) ? sample_at(pixels.data(), 2 * type.bitdepth, type.bitdepth) : in.key_r;
+        }
+        LodePNGColorMode wide = lodepng_color_mode_make(LCT_RGBA, 16);
+        std::vector<unsigned char> reference(width * 8);
+        unsigned error = lodepng_convert(reference.data(), pixels.data(), &wide, &in, width, 1);
+        check(error == 0, "convert: to 16 bits");
+        for (LodePNGColorType output : outputs) {
+          LodePNGColorMode out = lodepng_color_mode_make(output, 8);
+          size_t channels = lodepng_get_bpp(&out) / 8;
+          std::vector<unsigned char> row(width * channels);
+          char what[96];
+          snprintf(what, sizeof(what), "convert: colortype %d bitdepth %u palette %u key %d to colortype %d",
+            (int)type.colortype, type.bitdepth, palette ? palette_size : 0, keyed, (int)output);
+          error = lodepng_convert(row.data(), pixels.data(), &out, &in, width, 1);
+          bool same = (error == 0);
+          for (size_t i = 0; same && i < row.size(); i++)
+            same = (row[i] == reference[(i / channels) * 8 + (i % channels) * 2]);
+          check(same, what);
+          sum.add(row.data(), row.size());
+          lodepng_color_mode_cleanup(&out);
+        }
+        lodepng_color_mode_cleanup(&wide);
+        lodepng_color_mode_cleanup(&in);
+      }
+    }
+  }
+  sum.print("convert");
+}
+
+// the bytewise table loop lodepng_crc32 used before slicing-by-8 and pclmulqdq.
+unsigned crc32_reference(const unsigned char *data, size_t size) {
+  static unsigned table[256];
+  if (table[1] == 0) {
+    for (unsigned n = 0; n < 256; n++) {
+      unsigned c = n;
+      for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      table[n] = c;
+    }
+  }
+  unsigned crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; i++)
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return crc ^ 0xFFFFFFFFu;
+}
+
+// every length up to a few folding blocks, then random ones, each at a random alignment.
+void check_crc32() {
+  std::vector<unsigned char> buffer(70000 + 64);
+  for (unsigned char &byte : buffer) byte = (unsigned char)random_next();
+  digest sum;
+  for (unsigned round = 0; round < 512 + 256; round++) {
+    size_t size = (round < 512) ? round : random_next() % 70000;
+    const unsigned char *data = buffer.data() + random_next() % 32;
+    unsigned crc = lodepng_crc32(data, size);
+    char what[64];
+    snprintf(what, sizeof(what), "crc32: length %zu", size);
+    check(crc == crc32_reference(data, size), what);
+    unsigned char bytes[4] = { (unsigned char)(crc >> 24), (unsigned char)(crc >> 16),
+      (unsigned char)(crc >> 8), (unsigned char)crc };
+    sum.add(bytes, 4);
+  }
+  sum.print("crc32");
+}
+
+// megabytes per second of lodepng_crc32 and of the bytewise loop, at chunk sizes icons and assets have.
+volatile unsigned crc_sink; // keeps the timed calls from being optimized away.
+
+void bench_crc32() {
+  const size_t sizes[] = { 64, 4096, 65536, 1 << 20 };
+  std::vector<unsigned char> buffer(1 << 20);
+  for (unsigned char &byte : buffer) byte = (unsigned char)random_next();
+  for (size_t size : sizes) {
+    double rate[2];
+    for (int bytewise = 0; bytewise < 2; bytewise++) {
+      unsigned crc = 0;
+      size_t total = 0;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      std::chrono::duration<double> elapsed(0);
+      while (elapsed.count() < 0.25) {
+        for (int i = 0; i < 16; i++, total += size)
+          crc ^= bytewise ? crc32_reference(buffer.data(), size) : lodepng_crc32(buffer.data(), size);
+        elapsed = std::chrono::steady_clock::now() - start;
+      }
+      rate[bytewise] = total / elapsed.count() / 1e6;
+      crc_sink = crc;
+    }
+    printf("crc32 %7zu bytes: %8.1f MB/s, bytewise %7.1f MB/s\n", size, rate[0], rate[1]);
+  }
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    bench_crc32();
+    return 0;
+  }
+  check_unfilter();
+  check_adler32();
+  check_crc32();
+  check_convert();
+  return failures ? 1 : 0;
+}